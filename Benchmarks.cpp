@@ -0,0 +1,245 @@
+#include "ctre/phoenix6/TalonFX.hpp"
+#include "ctre/phoenix6/unmanaged/Unmanaged.hpp" // for FeedEnable
+#include "ControlWriter.hpp"
+#include "GameController.hpp"
+#include "Joystick.hpp"
+#include "LatencyHistogram.hpp"
+#include "NetworkController.hpp"
+#include "RobotBase.hpp"
+#include "VirtualController.hpp"
+#include <string>
+#include <vector>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace ctre::phoenix6;
+
+namespace {
+
+/**
+ * The result of one benchmark, with durations per call.
+ */
+struct Result {
+    std::string name;
+    uint64_t samples;
+    uint64_t callsPerSample;
+    LatencyHistogram::Summary summary;
+};
+
+/* keeps the compiler from optimizing away the benchmarked calls */
+volatile double s_sink;
+
+/**
+ * Times the given function, calling it callsPerSample times
+ * per sample so that calls much shorter than the clock
+ * overhead are still resolved.
+ */
+template <typename Func>
+Result Measure(char const *name, uint64_t samples, uint64_t callsPerSample, Func &&func)
+{
+    /* warm up caches and lazy initialization */
+    for (uint64_t i = 0; i < callsPerSample; ++i) {
+        func();
+    }
+
+    LatencyHistogram histogram;
+    for (uint64_t i = 0; i < samples; ++i) {
+        auto const start = std::chrono::steady_clock::now();
+        for (uint64_t j = 0; j < callsPerSample; ++j) {
+            func();
+        }
+        histogram.Record(std::chrono::steady_clock::now() - start);
+    }
+
+    /* scale after summarizing, so calls under a nanosecond keep their resolution */
+    auto summary = histogram.GetSummary();
+    double const scale = 1.0 / callsPerSample;
+    summary.min = summary.min * scale;
+    summary.mean = summary.mean * scale;
+    summary.p50 = summary.p50 * scale;
+    summary.p99 = summary.p99 * scale;
+    summary.p999 = summary.p999 * scale;
+    summary.max = summary.max * scale;
+    return Result{name, samples, callsPerSample, summary};
+}
+
+/**
+ * A robot with empty periodic functions, measuring the
+ * overhead and wake-up jitter of the robot loop itself.
+ */
+class EmptyRobot : public RobotBase {
+private:
+    uint64_t _cycles = 0;
+    uint64_t const _limit;
+
+public:
+    explicit EmptyRobot(uint64_t cycles) : _limit{cycles} {}
+
+    void RobotInit() override {}
+    void RobotPeriodic() override { ++_cycles; }
+
+    bool IsEnabled() override { return false; }
+    void EnabledInit() override {}
+    void EnabledPeriodic() override {}
+
+    void DisabledInit() override {}
+    void DisabledPeriodic() override {}
+
+    bool IsRunning() override { return _cycles < _limit; }
+};
+
+void RunLoopBenchmarks(std::vector<Result> &results, uint64_t cycles)
+{
+    EmptyRobot robot{cycles};
+    robot.SetLoopTime(1_ms);
+    robot.Run();
+
+    results.push_back(Result{"loop/cycle", cycles, 1, robot.GetLoopStats(RobotBase::LoopPhase::Cycle)});
+    results.push_back(Result{"loop/wakeup_error", cycles, 1, robot.GetLoopStats(RobotBase::LoopPhase::WakeupError)});
+    results.push_back(Result{"loop/period_jitter", cycles, 1, robot.GetLoopStats(RobotBase::LoopPhase::PeriodJitter)});
+}
+
+void RunControlBenchmarks(std::vector<Result> &results, uint64_t samples)
+{
+    /* no device needs to be present; this measures the cost of the call on the loop thread */
+    hardware::TalonFX motor{0, "*"};
+    controls::DutyCycleOut dutyCycle{0};
+    controls::NeutralOut neutral{};
+    ControlWriter writer{motor};
+
+    results.push_back(Measure("control/duty_cycle_out", samples, 1, [&] {
+        dutyCycle.Output = dutyCycle.Output.value() > 0 ? 0 : 0.1;
+        motor.SetControl(dutyCycle);
+    }));
+    results.push_back(Measure("control/neutral_out", samples, 1, [&] {
+        motor.SetControl(neutral);
+    }));
+    results.push_back(Measure("control/writer_suppressed", samples, 10, [&] {
+        writer.SetControl(neutral);
+    }));
+    results.push_back(Measure("control/feed_enable", samples, 1, [] {
+        ctre::phoenix::unmanaged::FeedEnable(100);
+    }));
+}
+
+template <typename Device>
+void RunInputBenchmarks(std::vector<Result> &results, uint64_t samples, std::string const &prefix, Device &device)
+{
+    results.push_back(Measure((prefix + "/periodic").c_str(), samples, 10, [&] {
+        device.Periodic();
+    }));
+    results.push_back(Measure((prefix + "/get_axis").c_str(), samples, 100, [&] {
+        s_sink = device.GetAxis(1);
+    }));
+    results.push_back(Measure((prefix + "/get_button").c_str(), samples, 100, [&] {
+        s_sink = device.GetButton(5);
+    }));
+    results.push_back(Measure((prefix + "/snapshot").c_str(), samples, 100, [&] {
+        auto const &input = device.Snapshot();
+        s_sink = input.GetButton(5) ? input.axes[1] : input.axes[4];
+    }));
+}
+
+void PrintTable(std::vector<Result> const &results)
+{
+    printf("%-28s %10s %10s %10s %10s %10s %10s %10s\n",
+            "Benchmark (ns)", "samples", "min", "mean", "p50", "p99", "p99.9", "max");
+    for (auto const &result : results) {
+        auto const &s = result.summary;
+        printf("%-28s %10llu %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f\n",
+                result.name.c_str(), (unsigned long long)result.samples,
+                s.min.value() * 1000, s.mean.value() * 1000, s.p50.value() * 1000,
+                s.p99.value() * 1000, s.p999.value() * 1000, s.max.value() * 1000);
+    }
+}
+
+void WriteJson(std::vector<Result> const &results, FILE *file)
+{
+    fprintf(file, "{\n  \"benchmarks\": [\n");
+    for (size_t i = 0; i < results.size(); ++i) {
+        auto const &result = results[i];
+        auto const &s = result.summary;
+        fprintf(file, "    {\"name\": \"%s\", \"samples\": %llu, \"calls_per_sample\": %llu, "
+                "\"min_ns\": %.1f, \"mean_ns\": %.1f, \"p50_ns\": %.1f, \"p99_ns\": %.1f, "
+                "\"p999_ns\": %.1f, \"max_ns\": %.1f}%s\n",
+                result.name.c_str(), (unsigned long long)result.samples, (unsigned long long)result.callsPerSample,
+                s.min.value() * 1000, s.mean.value() * 1000, s.p50.value() * 1000, s.p99.value() * 1000,
+                s.p999.value() * 1000, s.max.value() * 1000,
+                i + 1 < results.size() ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+}
+
+}
+
+/**
+ * Measures the hot paths of the robot loop: scheduling overhead
+ * and wake-up jitter of an empty loop, control requests,
+ * FeedEnable, and input handling. No CAN devices or controllers
+ * need to be present. Durations are per call, in nanoseconds.
+ *
+ * Usage: ./Phoenix6-Benchmarks [--json <file>] [--filter <prefix>] [--loop-cycles <n>]
+ *  --json also writes the results as JSON to the file
+ *  --filter only runs the groups starting with the prefix (loop, control, joystick, gamecontroller, virtual, network)
+ */
+int main(int argc, char **argv)
+{
+    char const *jsonPath = nullptr;
+    std::string filter;
+    uint64_t loopCycles = 2000;
+    uint64_t const samples = 10000;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            jsonPath = argv[++i];
+        } else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (strcmp(argv[i], "--loop-cycles") == 0 && i + 1 < argc) {
+            loopCycles = strtoull(argv[++i], nullptr, 10);
+        } else {
+            fprintf(stderr, "Usage: %s [--json <file>] [--filter <prefix>] [--loop-cycles <n>]\n", argv[0]);
+            return 1;
+        }
+    }
+    auto const enabled = [&](char const *group) {
+        return filter.empty() || strncmp(group, filter.c_str(), filter.size()) == 0;
+    };
+
+    std::vector<Result> results;
+    if (enabled("loop")) {
+        RunLoopBenchmarks(results, loopCycles);
+    }
+    if (enabled("control")) {
+        RunControlBenchmarks(results, samples);
+    }
+    if (enabled("joystick")) {
+        Joystick joystick{0};
+        RunInputBenchmarks(results, samples, "joystick", joystick);
+    }
+    if (enabled("gamecontroller")) {
+        GameController controller{0};
+        RunInputBenchmarks(results, samples, "gamecontroller", controller);
+    }
+    if (enabled("virtual")) {
+        VirtualController controller{0};
+        RunInputBenchmarks(results, samples, "virtual", controller);
+    }
+    if (enabled("network")) {
+        NetworkController controller{0};
+        RunInputBenchmarks(results, samples, "network", controller);
+    }
+
+    PrintTable(results);
+    if (jsonPath != nullptr) {
+        FILE *file = fopen(jsonPath, "w");
+        if (file == nullptr) {
+            fprintf(stderr, "Error: Could not write %s: %s\n", jsonPath, strerror(errno));
+            return 1;
+        }
+        WriteJson(results, file);
+        fclose(file);
+    }
+    return 0;
+}
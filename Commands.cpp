@@ -0,0 +1,225 @@
+#include "Commands.hpp"
+
+#if ROBOT_COMMANDS
+
+#include <stdio.h>
+
+namespace {
+
+int s_numSubsystems = 0;
+
+}
+
+Subsystem::Subsystem()
+{
+    if (s_numSubsystems >= 64) {
+        fprintf(stderr, "Warning: Only 64 subsystems are supported, commands will not conflict over this one\n");
+        _mask = 0;
+        return;
+    }
+    _mask = uint64_t{1} << s_numSubsystems++;
+}
+
+/*static*/ std::array<CommandFramePool::Block, CommandFramePool::kMaxFrames> CommandFramePool::s_blocks;
+/*static*/ CommandFramePool::Block *CommandFramePool::s_free = nullptr;
+/*static*/ size_t CommandFramePool::s_numFree = 0;
+/*static*/ uint64_t CommandFramePool::s_failures = 0;
+/*static*/ bool CommandFramePool::s_initialized = false;
+
+/*static*/ void *CommandFramePool::Allocate(size_t size) noexcept
+{
+    if (!s_initialized) {
+        for (auto &block : s_blocks) {
+            block.next = s_free;
+            s_free = &block;
+        }
+        s_numFree = kMaxFrames;
+        s_initialized = true;
+    }
+
+    if (size > kFrameSize || s_free == nullptr) {
+        ++s_failures;
+        return nullptr;
+    }
+    Block *const block = s_free;
+    s_free = block->next;
+    --s_numFree;
+    return block->bytes;
+}
+
+/*static*/ void CommandFramePool::Free(void *frame) noexcept
+{
+    Block *const block = static_cast<Block *>(frame);
+    block->next = s_free;
+    s_free = block;
+    ++s_numFree;
+}
+
+std::coroutine_handle<> Command::FinalAwaiter::await_suspend(Handle handle) noexcept
+{
+    /* a child command resumes its parent right away; a root command stays suspended for Tick() */
+    std::coroutine_handle<> const continuation = handle.promise().continuation;
+    if (continuation) {
+        CommandScheduler::SetActive(continuation);
+        return continuation;
+    }
+    return std::noop_coroutine();
+}
+
+std::coroutine_handle<> Command::ChildAwaiter::await_suspend(std::coroutine_handle<> parent) noexcept
+{
+    child.promise().continuation = parent;
+    CommandScheduler::SetActive(child);
+    return child;
+}
+
+/*static*/ CommandScheduler *CommandScheduler::s_running = nullptr;
+/*static*/ CommandScheduler::Task *CommandScheduler::s_task = nullptr;
+
+CommandScheduler::CommandId CommandScheduler::Schedule(Command command)
+{
+    if (!command.IsValid()) {
+        ++_frameFailures;
+        return 0;
+    }
+    Command::Handle const handle = command.Release();
+    auto const &promise = handle.promise();
+
+    /* check every conflict before canceling any of them */
+    bool conflict = _numTasks >= kMaxCommands;
+    for (size_t i = 0; i < _numTasks && !conflict; ++i) {
+        Task const &task = _tasks[i];
+        if (!task.canceled && !task.interruptible && (task.requirements & promise.requirements) != 0) {
+            conflict = true;
+        }
+    }
+    if (conflict) {
+        handle.destroy();
+        ++_rejected;
+        return 0;
+    }
+    for (size_t i = 0; i < _numTasks; ++i) {
+        if ((_tasks[i].requirements & promise.requirements) != 0) {
+            _tasks[i].canceled = true;
+        }
+    }
+
+    Task &task = _tasks[_numTasks++];
+    task = Task{
+        handle,
+        handle,
+        nullptr,
+        nullptr,
+        ++_nextId,
+        promise.requirements,
+        promise.interruptible,
+        promise.runsWhenDisabled,
+        false,
+    };
+    ++_scheduled;
+    if (_numTasks > _peakRunning) {
+        _peakRunning = _numTasks;
+    }
+    return task.id;
+}
+
+void CommandScheduler::Cancel(CommandId id)
+{
+    for (size_t i = 0; i < _numTasks; ++i) {
+        if (_tasks[i].id == id) {
+            _tasks[i].canceled = true;
+        }
+    }
+}
+
+void CommandScheduler::CancelAll()
+{
+    for (size_t i = 0; i < _numTasks; ++i) {
+        _tasks[i].canceled = true;
+    }
+}
+
+void CommandScheduler::OnDisabled()
+{
+    for (size_t i = 0; i < _numTasks; ++i) {
+        if (!_tasks[i].runsWhenDisabled) {
+            _tasks[i].canceled = true;
+        }
+    }
+}
+
+bool CommandScheduler::IsRunning(CommandId id) const
+{
+    for (size_t i = 0; i < _numTasks; ++i) {
+        if (_tasks[i].id == id) return !_tasks[i].canceled;
+    }
+    return false;
+}
+
+bool CommandScheduler::IsRequired(Subsystem const &subsystem) const
+{
+    for (size_t i = 0; i < _numTasks; ++i) {
+        if (!_tasks[i].canceled && (_tasks[i].requirements & subsystem.GetMask()) != 0) return true;
+    }
+    return false;
+}
+
+void CommandScheduler::Tick(units::second_t now)
+{
+    _now = now;
+    s_running = this;
+
+    /* commands scheduled by other commands are appended, and run in this same pass */
+    for (size_t i = 0; i < _numTasks; ++i) {
+        Task &task = _tasks[i];
+        if (task.canceled) continue;
+        if (task.ready != nullptr && !task.ready(task.awaiter)) continue;
+
+        task.ready = nullptr;
+        task.awaiter = nullptr;
+        s_task = &task;
+        task.active.resume();
+        s_task = nullptr;
+
+        if (task.root.done()) {
+            task.canceled = true;
+        }
+    }
+
+    Collect();
+}
+
+void CommandScheduler::Collect()
+{
+    /* destroying a root command also destroys the children it awaits */
+    size_t kept = 0;
+    for (size_t i = 0; i < _numTasks; ++i) {
+        if (_tasks[i].canceled) {
+            _tasks[i].root.destroy();
+        } else {
+            _tasks[kept++] = _tasks[i];
+        }
+    }
+    _numTasks = kept;
+}
+
+CommandScheduler::Stats CommandScheduler::GetStats() const
+{
+    return Stats{
+        _numTasks,
+        _peakRunning,
+        _scheduled,
+        _rejected,
+        _frameFailures,
+        CommandFramePool::GetFree(),
+    };
+}
+
+/*static*/ void CommandScheduler::Suspend(std::coroutine_handle<> handle, void const *awaiter, bool (*ready)(void const *))
+{
+    s_task->active = handle;
+    s_task->awaiter = awaiter;
+    s_task->ready = ready;
+}
+
+#endif
@@ -0,0 +1,456 @@
+#pragma once
+
+/* set by the ROBOT_COMMANDS CMake option, which builds with C++20 */
+#ifndef ROBOT_COMMANDS
+#define ROBOT_COMMANDS 0
+#endif
+
+#if ROBOT_COMMANDS
+
+#include "ctre/phoenix6/StatusSignal.hpp"
+#include "units/time.h"
+#include <array>
+#include <coroutine>
+#include <cstddef>
+#include <utility>
+#include <stdint.h>
+#include <stdlib.h>
+
+class CommandScheduler;
+
+/**
+ * A part of the robot that only one command may use at a
+ * time, such as the drivetrain. A program may have up to 64.
+ */
+class Subsystem {
+    uint64_t _mask;
+
+public:
+    Subsystem();
+
+    Subsystem(Subsystem const &) = delete;
+    Subsystem &operator=(Subsystem const &) = delete;
+
+    uint64_t GetMask() const { return _mask; }
+};
+
+/**
+ * Preallocated pool of coroutine frames for commands, so that
+ * starting a command never allocates. A command whose frame
+ * does not fit in kFrameSize, or that is started when the pool
+ * is empty, is invalid and fails to schedule.
+ *
+ * Commands must only be created on the robot loop thread.
+ */
+class CommandFramePool {
+public:
+    static constexpr size_t kFrameSize = 512;
+    static constexpr size_t kMaxFrames = 1024;
+
+    static void *Allocate(size_t size) noexcept;
+    static void Free(void *frame) noexcept;
+
+    /** Returns the number of unused frames. */
+    static size_t GetFree() { return s_numFree; }
+    /** Returns the number of frames that could not be allocated. */
+    static uint64_t GetFailures() { return s_failures; }
+
+private:
+    union Block {
+        Block *next;
+        alignas(std::max_align_t) unsigned char bytes[kFrameSize];
+    };
+
+    static std::array<Block, kMaxFrames> s_blocks;
+    static Block *s_free;
+    static size_t s_numFree;
+    static uint64_t s_failures;
+    static bool s_initialized;
+};
+
+/**
+ * A command of the robot, written as a coroutine returning
+ * Command. It runs on the robot loop thread once scheduled,
+ * one step per loop cycle, between the points where it waits:
+ *
+ *     Command Robot::DriveAndTurn()
+ *     {
+ *         drive = 0.3;
+ *         co_await WaitFor(2_s);
+ *         drive = 0;
+ *         co_await WaitForUpdate(leftVelocity);
+ *         co_await TurnBy(90_deg); // another command, run inline
+ *     }
+ *
+ *     commands.Schedule(DriveAndTurn().Requires(drivetrain));
+ *
+ * Commands never run concurrently with the loop, so they may
+ * freely use the robot's state.
+ */
+class [[nodiscard]] Command {
+public:
+    struct promise_type;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    /**
+     * Resumes whichever coroutine awaited the one finishing.
+     */
+    struct FinalAwaiter {
+        bool await_ready() const noexcept { return false; }
+        std::coroutine_handle<> await_suspend(Handle handle) noexcept;
+        void await_resume() const noexcept {}
+    };
+
+    struct promise_type {
+        /* the command awaiting this one, if any */
+        std::coroutine_handle<> continuation{};
+        uint64_t requirements = 0;
+        bool interruptible = true;
+        bool runsWhenDisabled = false;
+
+        Command get_return_object() noexcept { return Command{Handle::from_promise(*this)}; }
+        static Command get_return_object_on_allocation_failure() noexcept { return Command{}; }
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+        FinalAwaiter final_suspend() const noexcept { return {}; }
+        void return_void() const noexcept {}
+        /* the robot program is built without exceptions in mind */
+        void unhandled_exception() const noexcept { abort(); }
+
+        static void *operator new(size_t size) noexcept { return CommandFramePool::Allocate(size); }
+        static void operator delete(void *frame) noexcept { CommandFramePool::Free(frame); }
+    };
+
+    /**
+     * Runs a command inside the one awaiting it.
+     */
+    struct ChildAwaiter {
+        Handle child;
+
+        ~ChildAwaiter()
+        {
+            if (child) child.destroy();
+        }
+        /* a command that failed to allocate is skipped */
+        bool await_ready() const noexcept { return !child; }
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> parent) noexcept;
+        void await_resume() const noexcept {}
+    };
+
+private:
+    Handle _handle{};
+
+    explicit Command(Handle handle) : _handle{handle} {}
+
+public:
+    Command() = default;
+    ~Command()
+    {
+        if (_handle) _handle.destroy();
+    }
+
+    Command(Command &&other) noexcept : _handle{std::exchange(other._handle, {})} {}
+    Command &operator=(Command &&other) noexcept
+    {
+        if (this != &other) {
+            if (_handle) _handle.destroy();
+            _handle = std::exchange(other._handle, {});
+        }
+        return *this;
+    }
+
+    /**
+     * Returns whether the command was created, which fails
+     * when its frame does not fit in the frame pool.
+     */
+    bool IsValid() const { return (bool)_handle; }
+
+    /**
+     * Adds a subsystem the command uses. Scheduling it cancels
+     * the commands using any of the same subsystems.
+     */
+    Command &Requires(Subsystem const &subsystem) &
+    {
+        if (_handle) _handle.promise().requirements |= subsystem.GetMask();
+        return *this;
+    }
+    Command &&Requires(Subsystem const &subsystem) &&
+    {
+        return std::move(Requires(subsystem));
+    }
+
+    /**
+     * Makes the command reject being canceled by a command
+     * that requires the same subsystems.
+     */
+    Command &Uninterruptible() &
+    {
+        if (_handle) _handle.promise().interruptible = false;
+        return *this;
+    }
+    Command &&Uninterruptible() &&
+    {
+        return std::move(Uninterruptible());
+    }
+
+    /**
+     * Keeps the command running when the robot is disabled.
+     */
+    Command &RunsWhenDisabled() &
+    {
+        if (_handle) _handle.promise().runsWhenDisabled = true;
+        return *this;
+    }
+    Command &&RunsWhenDisabled() &&
+    {
+        return std::move(RunsWhenDisabled());
+    }
+
+    /**
+     * Hands the coroutine to the caller.
+     */
+    Handle Release() { return std::exchange(_handle, {}); }
+
+    /**
+     * Runs the command inside the awaiting one, which resumes
+     * once it completes. Its requirements are not checked.
+     */
+    ChildAwaiter operator co_await() && noexcept { return ChildAwaiter{Release()}; }
+};
+
+/**
+ * Ticks the scheduled commands once per robot loop cycle.
+ * Up to kMaxCommands may run at once, and neither scheduling
+ * nor running them allocates.
+ */
+class CommandScheduler {
+public:
+    static constexpr size_t kMaxCommands = 512;
+
+    /**
+     * Identifies a scheduled command, or 0 if it failed to schedule.
+     */
+    using CommandId = uint64_t;
+
+    /**
+     * Statistics of the scheduler.
+     */
+    struct Stats {
+        /** Commands running now */
+        size_t running;
+        /** Most commands that ran at once */
+        size_t peakRunning;
+        /** Commands that were scheduled */
+        uint64_t scheduled;
+        /** Commands that were rejected for an uninterruptible conflict or a full scheduler */
+        uint64_t rejected;
+        /** Commands that could not get a frame from the pool */
+        uint64_t frameFailures;
+        /** Unused frames left in the pool */
+        size_t freeFrames;
+    };
+
+    /**
+     * Base of the awaitables that suspend a command until they
+     * are ready, checked once per Tick().
+     */
+    template <typename Derived>
+    struct Awaiter {
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle) noexcept
+        {
+            auto *const self = static_cast<Derived *>(this);
+            self->Suspend();
+            CommandScheduler::Suspend(handle, self, [](void const *self) {
+                return static_cast<Derived const *>(self)->Ready();
+            });
+        }
+        void await_resume() const noexcept {}
+    };
+
+private:
+    struct Task {
+        Command::Handle root;
+        /* the innermost command, which is resumed next */
+        std::coroutine_handle<> active;
+        /* what the active command waits for, or nullptr to resume on the next tick */
+        bool (*ready)(void const *awaiter);
+        void const *awaiter;
+        CommandId id;
+        uint64_t requirements;
+        bool interruptible;
+        bool runsWhenDisabled;
+        bool canceled;
+    };
+
+    std::array<Task, kMaxCommands> _tasks{};
+    size_t _numTasks = 0;
+    CommandId _nextId = 0;
+    units::second_t _now = 0_s;
+
+    size_t _peakRunning = 0;
+    uint64_t _scheduled = 0;
+    uint64_t _rejected = 0;
+    uint64_t _frameFailures = 0;
+
+    /* the scheduler and task being resumed, for the awaitables */
+    static CommandScheduler *s_running;
+    static Task *s_task;
+
+public:
+    CommandScheduler() = default;
+    ~CommandScheduler() { CancelAll(); Collect(); }
+
+    CommandScheduler(CommandScheduler const &) = delete;
+    CommandScheduler &operator=(CommandScheduler const &) = delete;
+
+    /**
+     * Schedules a command, which first runs on the next Tick().
+     * Commands using any of its subsystems are canceled, unless
+     * one of them is uninterruptible, in which case the new
+     * command is rejected. Returns 0 if it was not scheduled.
+     */
+    CommandId Schedule(Command command);
+
+    /**
+     * Cancels the given command, if it is still running.
+     */
+    void Cancel(CommandId id);
+
+    /**
+     * Cancels every command.
+     */
+    void CancelAll();
+
+    /**
+     * Returns whether the given command is still running.
+     */
+    bool IsRunning(CommandId id) const;
+
+    /**
+     * Returns whether a running command uses the subsystem.
+     */
+    bool IsRequired(Subsystem const &subsystem) const;
+
+    /**
+     * Runs every command that is ready, until each one waits
+     * again or completes. Commands started this tick run too.
+     */
+    void Tick(units::second_t now);
+
+    /**
+     * Cancels the commands that do not run when disabled.
+     */
+    void OnDisabled();
+
+    /**
+     * Returns the time of the current tick.
+     */
+    units::second_t GetTime() const { return _now; }
+
+    /**
+     * Returns the statistics of the scheduler.
+     */
+    Stats GetStats() const;
+
+    /**
+     * Returns the scheduler running the current command.
+     */
+    static CommandScheduler &Current() { return *s_running; }
+
+    /**
+     * Suspends the current command until ready(awaiter) returns
+     * true on a later Tick(), then resumes the given coroutine.
+     * Custom awaitables call this from await_suspend().
+     */
+    static void Suspend(std::coroutine_handle<> handle, void const *awaiter, bool (*ready)(void const *));
+
+private:
+    friend struct Command::FinalAwaiter;
+    friend struct Command::ChildAwaiter;
+
+    static void SetActive(std::coroutine_handle<> handle) { s_task->active = handle; }
+    /** Destroys the canceled commands. */
+    void Collect();
+};
+
+/**
+ * Waits for the given duration of robot loop time.
+ */
+struct WaitFor : CommandScheduler::Awaiter<WaitFor> {
+    units::second_t duration;
+    units::second_t deadline = 0_s;
+
+    explicit WaitFor(units::second_t duration) : duration{duration} {}
+    void Suspend() { deadline = CommandScheduler::Current().GetTime() + duration; }
+    bool Ready() const { return CommandScheduler::Current().GetTime() >= deadline; }
+};
+
+/**
+ * Waits until the next robot loop cycle.
+ */
+struct NextCycle : CommandScheduler::Awaiter<NextCycle> {
+    void Suspend() {}
+    bool Ready() const { return true; }
+};
+
+/**
+ * Waits until the condition is true, checking it once per
+ * cycle, or until the optional timeout. Returns whether the
+ * condition became true.
+ */
+template <typename Condition>
+struct WaitUntil {
+    Condition condition;
+    units::second_t timeout;
+    units::second_t deadline = 0_s;
+
+    explicit WaitUntil(Condition condition, units::second_t timeout = 0_s) :
+        condition{std::move(condition)}, timeout{timeout}
+    {}
+
+    bool await_ready() { return condition(); }
+    void await_suspend(std::coroutine_handle<> handle) noexcept
+    {
+        deadline = CommandScheduler::Current().GetTime() + timeout;
+        CommandScheduler::Suspend(handle, this, [](void const *self) {
+            auto &awaiter = *const_cast<WaitUntil *>(static_cast<WaitUntil const *>(self));
+            return awaiter.condition() ||
+                (awaiter.timeout > 0_s && CommandScheduler::Current().GetTime() >= awaiter.deadline);
+        });
+    }
+    bool await_resume() { return condition(); }
+};
+
+/**
+ * Waits until the status signal has new data, or until the
+ * optional timeout. The signal must be refreshed by the robot
+ * loop, such as by DeviceRegistry::Refresh(). Returns whether
+ * new data arrived.
+ */
+struct WaitForUpdate {
+    ctre::phoenix6::BaseStatusSignal const &signal;
+    units::second_t timeout;
+    units::second_t lastTime = 0_s;
+    units::second_t deadline = 0_s;
+
+    explicit WaitForUpdate(ctre::phoenix6::BaseStatusSignal const &signal, units::second_t timeout = 0_s) :
+        signal{signal}, timeout{timeout}
+    {}
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> handle) noexcept
+    {
+        lastTime = signal.GetTimestamp().GetTime();
+        deadline = CommandScheduler::Current().GetTime() + timeout;
+        CommandScheduler::Suspend(handle, this, [](void const *self) {
+            auto const &awaiter = *static_cast<WaitForUpdate const *>(self);
+            return awaiter.Updated() ||
+                (awaiter.timeout > 0_s && CommandScheduler::Current().GetTime() >= awaiter.deadline);
+        });
+    }
+    bool await_resume() const { return Updated(); }
+
+    bool Updated() const { return signal.GetTimestamp().GetTime() != lastTime; }
+};
+
+#endif
@@ -0,0 +1,156 @@
+#pragma once
+
+#include "ctre/phoenix6/TalonFX.hpp"
+#include "units/time.h"
+#include <chrono>
+#include <variant>
+#include <stdint.h>
+
+/**
+ * Sends control requests to a TalonFX only when they change
+ * or when the keep-alive period comes due, instead of on
+ * every loop. This cuts bus load for outputs that hold
+ * steady, such as NeutralOut while disabled or a joystick
+ * that is not being moved.
+ *
+ * Requests are sent as one-shot frames (UpdateFreqHz = 0),
+ * so this writer alone decides which frames go on the bus.
+ * The device stops driving its output if it does not hear
+ * a control frame for too long, so keep the keep-alive
+ * period under 50 ms. A held request is resent once the
+ * next call, one call period later, would be past the
+ * keep-alive period, so no gap between frames exceeds it
+ * as long as SetControl() is called at that period.
+ */
+class ControlWriter {
+public:
+    /**
+     * The control requests this writer can send.
+     */
+    using Requests = std::variant<
+        std::monostate,
+        ctre::phoenix6::controls::DutyCycleOut,
+        ctre::phoenix6::controls::VelocityVoltage,
+        ctre::phoenix6::controls::NeutralOut
+    >;
+
+private:
+    ctre::phoenix6::hardware::TalonFX &_device;
+    std::chrono::nanoseconds _keepAlive;
+    /* resend a held request once it is this old */
+    std::chrono::nanoseconds _resendAfter{};
+
+    Requests _last{};
+    std::chrono::steady_clock::time_point _lastSent{};
+
+    uint64_t _sent = 0;
+    uint64_t _suppressed = 0;
+
+public:
+    /**
+     * Creates a writer for the given device, which is given
+     * requests every call period, such as the loop time.
+     */
+    ControlWriter(ctre::phoenix6::hardware::TalonFX &device, units::millisecond_t keepAlive = 45_ms,
+            units::millisecond_t callPeriod = 20_ms) :
+        _device{device},
+        _keepAlive{std::chrono::microseconds{(int64_t)units::microsecond_t{keepAlive}.value()}}
+    {
+        SetCallPeriod(callPeriod);
+    }
+
+    /**
+     * Sets how often SetControl() is called, so held requests
+     * are resent before the keep-alive period runs out.
+     */
+    void SetCallPeriod(units::millisecond_t callPeriod)
+    {
+        std::chrono::nanoseconds const period{std::chrono::microseconds{(int64_t)units::microsecond_t{callPeriod}.value()}};
+        _resendAfter = period < _keepAlive ? _keepAlive - period : std::chrono::nanoseconds{0};
+    }
+
+    /**
+     * Sends the given control request if it differs from the
+     * last request sent or the keep-alive period would elapse
+     * before the next call.
+     * A suppressed request returns OK.
+     */
+    template <typename Request>
+    ctre::phoenix::StatusCode SetControl(Request const &request)
+    {
+        auto const now = std::chrono::steady_clock::now();
+
+        auto const *last = std::get_if<Request>(&_last);
+        if (last && IsSameRequest(*last, request) && now - _lastSent < _resendAfter) {
+            /* nothing changed, and the device has heard from us recently */
+            ++_suppressed;
+            return ctre::phoenix::StatusCode::OK;
+        }
+
+        Request oneShot = request;
+        oneShot.UpdateFreqHz = 0_Hz;
+        auto const status = _device.SetControl(oneShot);
+        ++_sent;
+
+        if (status.IsOK()) {
+            _last = request;
+            _lastSent = now;
+        } else {
+            /* make sure we try again next time */
+            _last = std::monostate{};
+        }
+        return status;
+    }
+
+    /**
+     * Forces the next request to be sent, such as after the
+     * device has been reset or reconfigured.
+     */
+    void Invalidate()
+    {
+        _last = std::monostate{};
+    }
+
+    /**
+     * Returns the device this writer controls.
+     */
+    ctre::phoenix6::hardware::TalonFX &GetDevice() const { return _device; }
+
+    /**
+     * Returns the number of frames put on the bus.
+     */
+    uint64_t GetSentCount() const { return _sent; }
+
+    /**
+     * Returns the number of requests that were suppressed
+     * because they did not change.
+     */
+    uint64_t GetSuppressedCount() const { return _suppressed; }
+
+private:
+    static bool IsSameRequest(ctre::phoenix6::controls::DutyCycleOut const &a, ctre::phoenix6::controls::DutyCycleOut const &b)
+    {
+        return a.Output == b.Output &&
+            a.EnableFOC == b.EnableFOC &&
+            a.OverrideBrakeDurNeutral == b.OverrideBrakeDurNeutral &&
+            a.LimitForwardMotion == b.LimitForwardMotion &&
+            a.LimitReverseMotion == b.LimitReverseMotion;
+    }
+
+    static bool IsSameRequest(ctre::phoenix6::controls::VelocityVoltage const &a, ctre::phoenix6::controls::VelocityVoltage const &b)
+    {
+        return a.Velocity == b.Velocity &&
+            a.Acceleration == b.Acceleration &&
+            a.EnableFOC == b.EnableFOC &&
+            a.FeedForward == b.FeedForward &&
+            a.Slot == b.Slot &&
+            a.OverrideBrakeDurNeutral == b.OverrideBrakeDurNeutral &&
+            a.LimitForwardMotion == b.LimitForwardMotion &&
+            a.LimitReverseMotion == b.LimitReverseMotion;
+    }
+
+    static bool IsSameRequest(ctre::phoenix6::controls::NeutralOut const &, ctre::phoenix6::controls::NeutralOut const &)
+    {
+        return true;
+    }
+};
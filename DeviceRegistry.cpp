@@ -0,0 +1,352 @@
+#include "DeviceRegistry.hpp"
+#include "SingleWriter.hpp"
+#include <algorithm>
+#include <ctype.h>
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <variant>
+
+using namespace ctre::phoenix6;
+
+namespace {
+
+units::second_t ToSeconds(std::chrono::steady_clock::duration duration)
+{
+    return units::second_t{std::chrono::duration<double>(duration).count()};
+}
+
+/**
+ * Compares two serialized configs. Devices store some values
+ * with less precision than a double, so numbers only need to
+ * match within a small tolerance.
+ */
+bool SameSerializedConfig(std::string const &a, std::string const &b)
+{
+    char const *pa = a.c_str();
+    char const *pb = b.c_str();
+    while (*pa && *pb) {
+        bool const numA = isdigit((unsigned char)*pa) || *pa == '-' || *pa == '.';
+        bool const numB = isdigit((unsigned char)*pb) || *pb == '-' || *pb == '.';
+        if (numA && numB) {
+            char *endA;
+            char *endB;
+            double const va = strtod(pa, &endA);
+            double const vb = strtod(pb, &endB);
+            if (endA != pa && endB != pb) {
+                if (fabs(va - vb) > 1e-6 + 1e-4 * std::max(fabs(va), fabs(vb))) return false;
+                pa = endA;
+                pb = endB;
+                continue;
+            }
+        }
+        if (*pa++ != *pb++) return false;
+    }
+    return *pa == *pb;
+}
+
+/**
+ * Calls the function until it succeeds, at most 1 + retries times,
+ * and returns its last status.
+ */
+template <typename Func>
+ctre::phoenix::StatusCode Retry(int retries, int &attempts, Func &&func)
+{
+    ctre::phoenix::StatusCode status = ctre::phoenix::StatusCode::OK;
+    for (int i = 0; i <= retries; ++i) {
+        ++attempts;
+        status = func();
+        if (status.IsOK()) break;
+    }
+    return status;
+}
+
+}
+
+DeviceRegistry::Handle DeviceRegistry::AddTalonFX(int id, std::string const &canbus)
+{
+    auto device = std::make_unique<Device>();
+    device->bus = &GetBus(canbus);
+    device->device = std::make_unique<hardware::TalonFX>(id, canbus);
+    device->writer = std::make_unique<ControlWriter>(*device->device);
+    device->writer->SetCallPeriod(_controlPeriod);
+
+    device->bus->devices.push_back(device.get());
+    _devices.push_back(std::move(device));
+    return _devices.size() - 1;
+}
+
+void DeviceRegistry::SetControlPeriod(units::millisecond_t period)
+{
+    _controlPeriod = period;
+    for (auto &device : _devices) {
+        device->writer->SetCallPeriod(period);
+    }
+}
+
+void DeviceRegistry::AddSignals(Handle handle, std::vector<BaseStatusSignal *> const &signals)
+{
+    auto &busSignals = _devices[handle]->bus->signals;
+    busSignals.insert(busSignals.end(), signals.begin(), signals.end());
+}
+
+void DeviceRegistry::SetConfig(Handle handle, configs::TalonFXConfiguration const &config)
+{
+    _devices[handle]->config = std::make_unique<configs::TalonFXConfiguration>(config);
+}
+
+bool DeviceRegistry::ApplyConfigs()
+{
+    /* each read and apply blocks for a bus round trip, so give every device its own thread */
+    std::vector<std::thread> threads;
+    for (auto &device : _devices) {
+        if (device->config) {
+            threads.emplace_back(Configure, std::ref(*device), _configRetries);
+        }
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    bool ok = true;
+    for (auto const &device : _devices) {
+        if (device->configReport.configured && !device->configReport.status.IsOK()) {
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+/*static*/ void DeviceRegistry::Configure(Device &device, int retries)
+{
+    auto &configurator = device.device->GetConfigurator();
+    auto const &desired = *device.config;
+    ConfigReport &report = device.configReport;
+    report = ConfigReport{};
+    report.configured = true;
+
+    configs::TalonFXConfiguration current{};
+    auto start = std::chrono::steady_clock::now();
+    auto status = Retry(retries, report.attempts, [&] { return configurator.Refresh(current); });
+    report.readTime = ToSeconds(std::chrono::steady_clock::now() - start);
+
+    start = std::chrono::steady_clock::now();
+    if (!status.IsOK()) {
+        /* nothing to compare against, so apply everything */
+        report.fullApply = true;
+        report.status = Retry(retries, report.attempts, [&] { return configurator.Apply(desired); });
+    } else if (!SameSerializedConfig(desired.Serialize(), current.Serialize())) {
+        /* a full apply also resets every group the desired configuration leaves at its defaults,
+         * including groups added by newer Phoenix releases, so no stale setting survives */
+        report.changed = true;
+        report.status = Retry(retries, report.attempts, [&] { return configurator.Apply(desired); });
+    }
+    report.applyTime = ToSeconds(std::chrono::steady_clock::now() - start);
+}
+
+void DeviceRegistry::PrintConfigReports(FILE *file) const
+{
+    fprintf(file, "%-16s %6s %9s %9s %8s %7s %s\n",
+            "Bus", "device", "read ms", "apply ms", "attempts", "changed", "status");
+    for (auto const &device : _devices) {
+        auto const &report = device->configReport;
+        if (!report.configured) continue;
+        fprintf(file, "%-16s %6d %9.1f %9.1f %8d %7s %s\n",
+                device->bus->name.c_str(), device->device->GetDeviceID(),
+                report.readTime.value() * 1000, report.applyTime.value() * 1000, report.attempts,
+                report.fullApply ? "unread" : report.changed ? "yes" : "no",
+                report.status.IsOK() ? "OK" : report.status.GetName());
+    }
+}
+
+void DeviceRegistry::SetBusCpu(std::string const &canbus, int cpu)
+{
+    GetBus(canbus).cpu = cpu;
+}
+
+DeviceRegistry::Bus &DeviceRegistry::GetBus(std::string const &canbus)
+{
+    for (auto &bus : _buses) {
+        if (bus->name == canbus) return *bus;
+    }
+    _buses.push_back(std::make_unique<Bus>());
+    _buses.back()->name = canbus;
+    return *_buses.back();
+}
+
+void DeviceRegistry::Start()
+{
+    if (_started) return;
+    _started = true;
+
+    for (auto &busPtr : _buses) {
+        Bus &bus = *busPtr;
+        bus.thread = std::thread{Worker, std::ref(bus), _refreshTimeout};
+
+        if (bus.cpu >= 0) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(bus.cpu, &set);
+            int const err = pthread_setaffinity_np(bus.thread.native_handle(), sizeof(set), &set);
+            if (err != 0) {
+                fprintf(stderr, "Warning: Could not pin the worker of bus \"%s\" to CPU %d: %s\n",
+                        bus.name.c_str(), bus.cpu, strerror(err));
+            }
+        }
+    }
+}
+
+void DeviceRegistry::Stop()
+{
+    if (!_started) return;
+    _started = false;
+
+    for (auto &bus : _buses) {
+        Dispatch(*bus, Job::Stop);
+    }
+    for (auto &bus : _buses) {
+        bus->thread.join();
+    }
+}
+
+ctre::phoenix::StatusCode DeviceRegistry::Refresh()
+{
+    /* fan out to every bus, then gather */
+    for (auto &bus : _buses) {
+        if (_started) {
+            Dispatch(*bus, Job::Refresh);
+        } else {
+            RunJob(*bus, Job::Refresh, _refreshTimeout);
+        }
+    }
+
+    ctre::phoenix::StatusCode status = ctre::phoenix::StatusCode::OK;
+    for (auto &bus : _buses) {
+        WaitIdle(*bus);
+        if (status.IsOK() && !bus->refreshStatus.IsOK()) {
+            status = bus->refreshStatus;
+        }
+    }
+    return status;
+}
+
+void DeviceRegistry::SendControls()
+{
+    for (auto &bus : _buses) {
+        if (_started) {
+            Dispatch(*bus, Job::SendControls);
+        } else {
+            RunJob(*bus, Job::SendControls, _refreshTimeout);
+        }
+    }
+}
+
+/*static*/ void DeviceRegistry::Dispatch(Bus &bus, Job job)
+{
+    {
+        std::unique_lock<std::mutex> lock{bus.mutex};
+        bus.cv.wait(lock, [&] { return !bus.busy; });
+        bus.job = job;
+        bus.busy = true;
+    }
+    bus.cv.notify_all();
+}
+
+/*static*/ void DeviceRegistry::WaitIdle(Bus &bus)
+{
+    std::unique_lock<std::mutex> lock{bus.mutex};
+    bus.cv.wait(lock, [&] { return !bus.busy; });
+}
+
+/*static*/ void DeviceRegistry::RunJob(Bus &bus, Job job, units::second_t refreshTimeout)
+{
+    auto const start = std::chrono::steady_clock::now();
+    switch (job) {
+        case Job::Refresh: {
+            if (bus.signals.empty()) break;
+            /* signals can only be waited on together when they share a bus, which is why each bus has its own worker */
+            bus.refreshStatus = refreshTimeout > 0_s ?
+                BaseStatusSignal::WaitForAll(refreshTimeout, bus.signals) :
+                BaseStatusSignal::RefreshAll(bus.signals);
+            if (!bus.refreshStatus.IsOK()) {
+                SingleWriterAdd(bus.errors);
+            }
+            bus.refreshTime.Record(std::chrono::steady_clock::now() - start);
+            break;
+        }
+        case Job::SendControls: {
+            for (Device *device : bus.devices) {
+                auto const status = std::visit([&](auto const &request) {
+                    if constexpr (std::is_same_v<std::decay_t<decltype(request)>, std::monostate>) {
+                        return ctre::phoenix::StatusCode{ctre::phoenix::StatusCode::OK};
+                    } else {
+                        return device->writer->SetControl(request);
+                    }
+                }, device->pending);
+                if (!status.IsOK()) {
+                    SingleWriterAdd(bus.errors);
+                }
+            }
+            bus.controlTime.Record(std::chrono::steady_clock::now() - start);
+            break;
+        }
+        case Job::Stop:
+        case Job::None:
+            break;
+    }
+}
+
+/*static*/ void DeviceRegistry::Worker(Bus &bus, units::second_t refreshTimeout)
+{
+    bool running = true;
+    while (running) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock{bus.mutex};
+            bus.cv.wait(lock, [&] { return bus.job != Job::None; });
+            job = bus.job;
+        }
+
+        if (job == Job::Stop) {
+            running = false;
+        } else {
+            RunJob(bus, job, refreshTimeout);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock{bus.mutex};
+            bus.job = Job::None;
+            bus.busy = false;
+        }
+        bus.cv.notify_all();
+    }
+}
+
+DeviceRegistry::BusStats DeviceRegistry::GetBusStats(size_t bus) const
+{
+    auto const &b = *_buses[bus];
+    return BusStats{
+        b.name,
+        b.devices.size(),
+        b.signals.size(),
+        b.refreshTime.GetSummary(),
+        b.controlTime.GetSummary(),
+        b.errors.load(std::memory_order_relaxed),
+    };
+}
+
+void DeviceRegistry::PrintStats(FILE *file) const
+{
+    fprintf(file, "%-16s %7s %7s %12s %12s %12s %12s %7s\n",
+            "Bus (us)", "devices", "signals", "refresh p50", "refresh max", "control p50", "control max", "errors");
+    for (size_t i = 0; i < _buses.size(); ++i) {
+        auto const stats = GetBusStats(i);
+        fprintf(file, "%-16s %7zu %7zu %12.1f %12.1f %12.1f %12.1f %7llu\n",
+                stats.name.c_str(), stats.devices, stats.signals,
+                stats.refresh.p50.value(), stats.refresh.max.value(),
+                stats.control.p50.value(), stats.control.max.value(),
+                (unsigned long long)stats.errors);
+    }
+}
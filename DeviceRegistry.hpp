@@ -0,0 +1,278 @@
+#pragma once
+
+#include "ControlWriter.hpp"
+#include "LatencyHistogram.hpp"
+#include "ctre/phoenix6/TalonFX.hpp"
+#include "units/time.h"
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * Owns the devices of the robot, grouped by CAN bus, and runs
+ * each bus's signal refreshes and control requests on its own
+ * worker thread. Work on different buses runs in parallel, so
+ * the time spent on bus I/O each cycle is that of the slowest
+ * bus rather than the sum of all of them.
+ *
+ * Each robot loop cycle should:
+ *  1. Refresh(), which waits for every bus to refresh its signals
+ *  2. read the signals and call SetControl() for the devices
+ *  3. SendControls(), which hands the requests to the workers
+ *     without waiting; the next Refresh() waits for them
+ *
+ * Devices and signals must be added before Start(). Control
+ * requests go through a ControlWriter per device, so only
+ * changed requests reach the bus.
+ */
+class DeviceRegistry {
+public:
+    /**
+     * Identifies a device in the registry.
+     */
+    using Handle = size_t;
+
+    /**
+     * Statistics of one bus worker.
+     */
+    struct BusStats {
+        std::string name;
+        size_t devices;
+        size_t signals;
+        /** Time to refresh or wait for the bus's signals */
+        LatencyHistogram::Summary refresh;
+        /** Time to send the bus's control requests */
+        LatencyHistogram::Summary control;
+        /** Number of refreshes and requests that returned an error */
+        uint64_t errors;
+    };
+
+    /**
+     * Result of configuring one device in ApplyConfigs().
+     */
+    struct ConfigReport {
+        /** Whether the device was given a configuration */
+        bool configured = false;
+        /** Time to read back the current configuration */
+        units::second_t readTime = 0_s;
+        /** Time to apply the configuration, if it was applied */
+        units::second_t applyTime = 0_s;
+        /** Attempts over all reads and applies, including retries */
+        int attempts = 0;
+        /** Whether the configuration on the device differed and was applied */
+        bool changed = false;
+        /** Whether the configuration was applied without comparing, as the read failed */
+        bool fullApply = false;
+        /** First error that was not resolved by a retry */
+        ctre::phoenix::StatusCode status = ctre::phoenix::StatusCode::OK;
+    };
+
+private:
+    enum class Job {
+        None,
+        Refresh,
+        SendControls,
+        Stop,
+    };
+
+    struct Bus;
+
+    struct Device {
+        Bus *bus;
+        std::unique_ptr<ctre::phoenix6::hardware::TalonFX> device;
+        std::unique_ptr<ControlWriter> writer;
+        /* written by the loop thread while the bus worker is idle */
+        ControlWriter::Requests pending{};
+
+        std::unique_ptr<ctre::phoenix6::configs::TalonFXConfiguration> config;
+        ConfigReport configReport;
+    };
+
+    struct Bus {
+        std::string name;
+        int cpu = -1;
+        std::vector<Device *> devices;
+        std::vector<ctre::phoenix6::BaseStatusSignal *> signals;
+
+        std::thread thread;
+        std::mutex mutex;
+        std::condition_variable cv;
+        Job job = Job::None;
+        bool busy = false;
+
+        LatencyHistogram refreshTime;
+        LatencyHistogram controlTime;
+        std::atomic<uint64_t> errors{0};
+        /* result of the last refresh, read by the loop thread after it completes */
+        ctre::phoenix::StatusCode refreshStatus = ctre::phoenix::StatusCode::OK;
+    };
+
+    std::vector<std::unique_ptr<Device>> _devices;
+    std::vector<std::unique_ptr<Bus>> _buses;
+    units::second_t _refreshTimeout = 0_s;
+    units::millisecond_t _controlPeriod = 20_ms;
+    int _configRetries = 3;
+    bool _started = false;
+
+public:
+    DeviceRegistry() = default;
+    ~DeviceRegistry() { Stop(); }
+
+    DeviceRegistry(DeviceRegistry const &) = delete;
+    DeviceRegistry &operator=(DeviceRegistry const &) = delete;
+
+    /**
+     * Creates a TalonFX with the given ID on the given bus.
+     */
+    Handle AddTalonFX(int id, std::string const &canbus);
+
+    /**
+     * Returns the given device. The reference stays valid for
+     * the lifetime of the registry.
+     */
+    ctre::phoenix6::hardware::TalonFX &Get(Handle handle) const
+    {
+        return *_devices[handle]->device;
+    }
+
+    /**
+     * Adds signals of the given device, which are refreshed by
+     * its bus worker in Refresh(). The signals must not be used
+     * by any other thread than the robot loop.
+     */
+    void AddSignals(Handle handle, std::vector<ctre::phoenix6::BaseStatusSignal *> const &signals);
+
+    /**
+     * Sets the configuration that ApplyConfigs() gives the device.
+     */
+    void SetConfig(Handle handle, ctre::phoenix6::configs::TalonFXConfiguration const &config);
+
+    /**
+     * Sets how many times a failed configuration read or apply
+     * is retried before ApplyConfigs() reports it. Defaults to 3.
+     */
+    void SetConfigRetries(int retries) { _configRetries = retries; }
+
+    /**
+     * Configures every device given a configuration, all in
+     * parallel. Each device's configuration is read back first,
+     * and the desired configuration is applied as a whole only if
+     * any of it differs, so a device that is already configured
+     * costs a single read. Returns whether every device was
+     * configured.
+     */
+    bool ApplyConfigs();
+
+    /**
+     * Returns the result of configuring the given device.
+     */
+    ConfigReport const &GetConfigReport(Handle handle) const
+    {
+        return _devices[handle]->configReport;
+    }
+
+    /**
+     * Prints a table of the result of configuring each device.
+     */
+    void PrintConfigReports(FILE *file = stdout) const;
+
+    /**
+     * Pins the worker of the given bus to a CPU. By default,
+     * workers keep the scheduling and affinity of the thread
+     * that calls Start().
+     */
+    void SetBusCpu(std::string const &canbus, int cpu);
+
+    /**
+     * Makes Refresh() wait up to the given timeout for new data
+     * on every signal of each bus, instead of returning the
+     * latest data immediately. Each bus waits independently.
+     */
+    void SetRefreshTimeout(units::second_t timeout)
+    {
+        _refreshTimeout = timeout;
+    }
+
+    /**
+     * Sets how often SendControls() is called, normally the
+     * loop time, so held requests are resent in time to keep
+     * the devices enabled. Defaults to 20 ms. This must be
+     * called before Start().
+     */
+    void SetControlPeriod(units::millisecond_t period);
+
+    /**
+     * Starts a worker thread per bus. Until then, Refresh()
+     * and SendControls() do the work of each bus in turn
+     * on the calling thread.
+     */
+    void Start();
+
+    /**
+     * Waits for outstanding work and stops the workers.
+     */
+    void Stop();
+
+    /**
+     * Refreshes the signals of every bus in parallel, returning
+     * once all of them are done. Returns the first error, if any.
+     */
+    ctre::phoenix::StatusCode Refresh();
+
+    /**
+     * Sets the control request sent to the device by the next
+     * SendControls(). Call this between Refresh() and SendControls().
+     */
+    template <typename Request>
+    void SetControl(Handle handle, Request const &request)
+    {
+        _devices[handle]->pending = request;
+    }
+
+    /**
+     * Returns the control request last set for the device.
+     */
+    ControlWriter::Requests const &GetControl(Handle handle) const
+    {
+        return _devices[handle]->pending;
+    }
+
+    /**
+     * Hands this cycle's control requests to the bus workers,
+     * without waiting for them to be sent.
+     */
+    void SendControls();
+
+    /**
+     * Returns the number of buses.
+     */
+    size_t GetNumBuses() const { return _buses.size(); }
+
+    /**
+     * Returns the statistics of the given bus.
+     */
+    BusStats GetBusStats(size_t bus) const;
+
+    /**
+     * Prints a table of the statistics of every bus.
+     */
+    void PrintStats(FILE *file = stdout) const;
+
+private:
+    Bus &GetBus(std::string const &canbus);
+    /** Waits for the bus to go idle, then gives it a job. */
+    static void Dispatch(Bus &bus, Job job);
+    /** Waits for the bus to go idle. */
+    static void WaitIdle(Bus &bus);
+    /** Does a job of the bus on the calling thread. */
+    static void RunJob(Bus &bus, Job job, units::second_t refreshTimeout);
+    static void Worker(Bus &bus, units::second_t refreshTimeout);
+    /** Configures a device on the calling thread. */
+    static void Configure(Device &device, int retries);
+};
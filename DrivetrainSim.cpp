@@ -0,0 +1,91 @@
+#include "DrivetrainSim.hpp"
+#include <math.h>
+#include <type_traits>
+#include <variant>
+
+using namespace ctre::phoenix6;
+
+DrivetrainSim::DrivetrainSim(hardware::TalonFX &leftLeader, hardware::TalonFX &leftFollower,
+                             hardware::TalonFX &rightLeader, hardware::TalonFX &rightFollower,
+                             Constants constants) :
+    _constants{constants},
+    _left{leftLeader, leftFollower},
+    _right{rightLeader, rightFollower}
+{
+    /* report the right side in its own inverted frame, so forward is positive on both sides */
+    _right.leader.GetSimState().Orientation = sim::ChassisReference::Clockwise_Positive;
+    _right.follower.GetSimState().Orientation = sim::ChassisReference::Clockwise_Positive;
+}
+
+DrivetrainSim::DrivetrainSim(hardware::TalonFX &leftLeader, hardware::TalonFX &leftFollower,
+                             hardware::TalonFX &rightLeader, hardware::TalonFX &rightFollower) :
+    DrivetrainSim{leftLeader, leftFollower, rightLeader, rightFollower, Constants{}}
+{}
+
+void DrivetrainSim::Update(units::second_t dt)
+{
+    double const dtSeconds = dt.value();
+    if (dtSeconds <= 0) return;
+
+    UpdateSide(_left, dtSeconds);
+    UpdateSide(_right, dtSeconds);
+
+    /* integrate the pose from the wheel speeds */
+    double const left = GetLeftSpeed();
+    double const right = GetRightSpeed();
+    double const speed = (left + right) / 2;
+    double const turnRate = (right - left) / _constants.trackWidthMeters;
+
+    _pose.xMeters += speed * cos(_pose.headingRadians) * dtSeconds;
+    _pose.yMeters += speed * sin(_pose.headingRadians) * dtSeconds;
+    _pose.headingRadians += turnRate * dtSeconds;
+}
+
+void DrivetrainSim::UpdateSide(Side &side, double dtSeconds)
+{
+    auto &leaderSim = side.leader.GetSimState();
+    auto &followerSim = side.follower.GetSimState();
+
+    leaderSim.SetSupplyVoltage(_constants.supplyVoltage);
+    followerSim.SetSupplyVoltage(_constants.supplyVoltage);
+
+    /* first-order motor: the rotor approaches the free speed scaled by the applied voltage;
+     * the follower applies the same voltage as the leader */
+    double const target = _constants.freeSpeed.value() * GetMotorVoltage(side) / _constants.supplyVoltage.value();
+    double const alpha = 1.0 - exp(-dtSeconds / _constants.timeConstant.value());
+    side.rotorTps += (target - side.rotorTps) * alpha;
+    side.rotorTurns += side.rotorTps * dtSeconds;
+
+    leaderSim.SetRawRotorPosition(units::turn_t{side.rotorTurns});
+    leaderSim.SetRotorVelocity(units::turns_per_second_t{side.rotorTps});
+    followerSim.SetRawRotorPosition(units::turn_t{side.rotorTurns});
+    followerSim.SetRotorVelocity(units::turns_per_second_t{side.rotorTps});
+}
+
+double DrivetrainSim::GetMotorVoltage(Side const &side) const
+{
+    double const supply = _constants.supplyVoltage.value();
+    double const volts = std::visit([&](auto const &request) {
+        using Request = std::decay_t<decltype(request)>;
+        if constexpr (std::is_same_v<Request, controls::DutyCycleOut>) {
+            return request.Output.value() * supply;
+        } else if constexpr (std::is_same_v<Request, controls::VelocityVoltage>) {
+            /* the device's velocity closed loop, with the static friction term in the direction of travel */
+            auto const &gains = _constants.velocityGains;
+            double const target = request.Velocity.value();
+            double const sign = target > 0 ? 1.0 : target < 0 ? -1.0 : 0.0;
+            return gains.kS * sign + gains.kV * target + gains.kP * (target - side.rotorTps) + request.FeedForward.value();
+        } else {
+            /* neutral, or nothing commanded yet */
+            return 0.0;
+        }
+    }, side.control);
+
+    /* the output cannot exceed the supply */
+    return volts > supply ? supply : volts < -supply ? -supply : volts;
+}
+
+double DrivetrainSim::WheelSpeed(Side const &side) const
+{
+    return side.rotorTps / _constants.gearRatio * 2 * M_PI * _constants.wheelRadiusMeters;
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "ControlWriter.hpp"
+#include "ctre/phoenix6/TalonFX.hpp"
+#include "units/time.h"
+
+/**
+ * A simple physics model of a differential drivetrain with a
+ * leader and follower TalonFX per side. Each update turns the
+ * control requests commanded to the leaders into motor voltages,
+ * steps a first-order motor model, and feeds the rotor position
+ * and velocity back to the Phoenix 6 simulation state of all
+ * four devices.
+ *
+ * The voltages are modelled from the requests instead of read
+ * from the simulated devices, because the devices run on the
+ * wall clock: their enable, control frames and closed loop would
+ * lag far behind a simulation running faster than real time.
+ *
+ * The right side is assumed to be inverted (Clockwise_Positive),
+ * so positive output drives both sides forward.
+ */
+class DrivetrainSim {
+public:
+    struct Constants {
+        /** Rotor free speed at the supply voltage */
+        units::turns_per_second_t freeSpeed{100};
+        /** Time for a side to reach 63% of its final speed */
+        units::second_t timeConstant{0.15};
+        /** Rotor turns per wheel turn */
+        double gearRatio = 10.71;
+        double wheelRadiusMeters = 0.0762;
+        double trackWidthMeters = 0.6;
+        /** Battery voltage supplied to the motors */
+        units::volt_t supplyVoltage{12};
+        /** The gains of the devices' velocity closed loop, used for VelocityVoltage requests */
+        ctre::phoenix6::configs::Slot0Configs velocityGains{};
+    };
+
+    /**
+     * The pose of the robot, starting at the origin facing +x.
+     */
+    struct Pose {
+        double xMeters;
+        double yMeters;
+        double headingRadians;
+    };
+
+private:
+    struct Side {
+        ctre::phoenix6::hardware::TalonFX &leader;
+        ctre::phoenix6::hardware::TalonFX &follower;
+        ControlWriter::Requests control{};
+        double rotorTurns = 0;
+        double rotorTps = 0;
+    };
+
+    Constants _constants;
+    Side _left;
+    Side _right;
+    Pose _pose{};
+
+public:
+    DrivetrainSim(ctre::phoenix6::hardware::TalonFX &leftLeader, ctre::phoenix6::hardware::TalonFX &leftFollower,
+                  ctre::phoenix6::hardware::TalonFX &rightLeader, ctre::phoenix6::hardware::TalonFX &rightFollower,
+                  Constants constants);
+    DrivetrainSim(ctre::phoenix6::hardware::TalonFX &leftLeader, ctre::phoenix6::hardware::TalonFX &leftFollower,
+                  ctre::phoenix6::hardware::TalonFX &rightLeader, ctre::phoenix6::hardware::TalonFX &rightFollower);
+
+    /**
+     * Sets the control requests commanded to the left and right
+     * leaders, which the followers follow, such as the requests
+     * of the last cycle from DeviceRegistry::GetControl().
+     */
+    void SetControls(ControlWriter::Requests const &left, ControlWriter::Requests const &right)
+    {
+        _left.control = left;
+        _right.control = right;
+    }
+
+    /**
+     * Advances the model by the given time step, applying the
+     * voltages of the control requests set since the last update.
+     */
+    void Update(units::second_t dt);
+
+    /**
+     * Returns the integrated pose of the robot.
+     */
+    Pose GetPose() const { return _pose; }
+
+    /**
+     * Returns the speed of the left wheels in meters per second.
+     */
+    double GetLeftSpeed() const { return WheelSpeed(_left); }
+
+    /**
+     * Returns the speed of the right wheels in meters per second.
+     */
+    double GetRightSpeed() const { return WheelSpeed(_right); }
+
+private:
+    void UpdateSide(Side &side, double dtSeconds);
+    /** Returns the voltage the device applies for the side's control request. */
+    double GetMotorVoltage(Side const &side) const;
+    double WheelSpeed(Side const &side) const;
+};
@@ -0,0 +1,116 @@
+#include "EnableSupervisor.hpp"
+#include "SingleWriter.hpp"
+#include "ctre/phoenix6/unmanaged/Unmanaged.hpp" // for FeedEnable
+#include <algorithm>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+
+void EnableSupervisor::Start(Settings settings, units::millisecond_t loopTime)
+{
+    if (_running.load(std::memory_order_relaxed)) return;
+
+    if (settings.period <= 0_ms) settings.period = loopTime;
+    if (settings.deadline <= 0_ms) settings.deadline = settings.period * 1.5;
+    if (settings.maxMissedCycles < 1) settings.maxMissedCycles = 1;
+    _settings = settings;
+    /* a few feed periods of slack, so supervisor jitter never lets the enable lapse */
+    _feedTimeoutMs = std::max(10, (int)(settings.feedPeriod.value() * 4));
+
+    /* no heartbeat yet, so the enable stays off until the loop asks for it */
+    _heartbeatNs.store(0, std::memory_order_relaxed);
+    _heartbeatEnabled.store(false, std::memory_order_relaxed);
+
+    _running.store(true, std::memory_order_relaxed);
+    _thread = std::thread{&EnableSupervisor::Run, this};
+
+    /* run above the robot loop, so a busy loop cannot starve the feed */
+    int policy;
+    sched_param param;
+    if (pthread_getschedparam(pthread_self(), &policy, &param) == 0 &&
+        (policy == SCHED_FIFO || policy == SCHED_RR))
+    {
+        param.sched_priority = std::min(param.sched_priority + 1, sched_get_priority_max(policy));
+        int const err = pthread_setschedparam(_thread.native_handle(), policy, &param);
+        if (err != 0) {
+            fprintf(stderr, "Warning: Could not raise the priority of the enable supervisor: %s\n", strerror(err));
+        }
+    }
+}
+
+void EnableSupervisor::Stop()
+{
+    if (!_running.exchange(false)) return;
+    _thread.join();
+}
+
+EnableSupervisor::Stats EnableSupervisor::GetStats() const
+{
+    return Stats{
+        _feeds.load(std::memory_order_relaxed),
+        _nearMisses.load(std::memory_order_relaxed),
+        _lapses.load(std::memory_order_relaxed),
+        units::millisecond_t{_worstAgeNs.load(std::memory_order_relaxed) / 1e6},
+        _interval.GetSummary(),
+    };
+}
+
+void EnableSupervisor::Run()
+{
+    using namespace std::chrono;
+
+    auto const feedPeriod = duration_cast<steady_clock::duration>(duration<double, std::milli>{_settings.feedPeriod.value()});
+    int64_t const deadlineNs = (int64_t)(_settings.deadline.value() * 1e6);
+    int64_t const maxAgeNs = (int64_t)(_settings.period.value() * 1e6 * _settings.maxMissedCycles);
+
+    int64_t lastHeartbeat = 0;
+    int64_t lateHeartbeat = 0;
+    bool feeding = false;
+
+    auto wake = steady_clock::now();
+    while (_running.load(std::memory_order_relaxed)) {
+        bool const enabled = _heartbeatEnabled.load(std::memory_order_acquire);
+        int64_t const heartbeat = _heartbeatNs.load(std::memory_order_relaxed);
+        int64_t const now = steady_clock::now().time_since_epoch().count();
+        int64_t const age = now - heartbeat;
+
+        if (heartbeat != lastHeartbeat) {
+            if (lastHeartbeat != 0) {
+                _interval.Record(nanoseconds{heartbeat - lastHeartbeat});
+            }
+            lastHeartbeat = heartbeat;
+        }
+
+        if (enabled && heartbeat != 0 && age < maxAgeNs) {
+            ctre::phoenix::unmanaged::FeedEnable(_feedTimeoutMs);
+            SingleWriterAdd(_feeds);
+            feeding = true;
+
+            if (age > deadlineNs && heartbeat != lateHeartbeat) {
+                /* the loop is late, but not late enough to drop the enable; count each heartbeat once */
+                SingleWriterAdd(_nearMisses);
+                lateHeartbeat = heartbeat;
+            }
+            if (age > _worstAgeNs.load(std::memory_order_relaxed)) {
+                _worstAgeNs.store(age, std::memory_order_relaxed);
+            }
+        } else {
+            if (feeding && enabled) {
+                /* the loop still wants the enable, but has stopped beating */
+                _lastLapseAgeNs.store(age, std::memory_order_relaxed);
+                SingleWriterAdd(_lapses);
+            }
+            /* the last feed times out on its own */
+            feeding = false;
+        }
+
+        /* stay on a fixed schedule, skipping any feeds we were too late for */
+        wake += feedPeriod;
+        auto const current = steady_clock::now();
+        if (wake < current) {
+            wake = current;
+        }
+        std::this_thread::sleep_until(wake);
+    }
+}
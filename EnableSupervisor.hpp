@@ -0,0 +1,128 @@
+#pragma once
+
+#include "LatencyHistogram.hpp"
+#include "units/time.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <stdint.h>
+
+/**
+ * Owns the enable feed of the devices on its own thread, and
+ * only feeds it while the robot loop keeps sending heartbeats.
+ *
+ * The loop calls Heartbeat() every cycle with whether the
+ * robot should be enabled. The supervisor feeds the enable
+ * every few milliseconds with a short timeout, as long as the
+ * last heartbeat asked for it and is younger than the allowed
+ * number of missed loop cycles. A single slow cycle therefore
+ * does not let the enable lapse, while a stalled loop drops it
+ * within a few cycles, even if it eventually returns.
+ *
+ * The thread runs one SCHED_FIFO priority above the thread that
+ * starts it, if that thread is real-time.
+ */
+class EnableSupervisor {
+public:
+    /**
+     * Thresholds of the supervisor.
+     */
+    struct Settings {
+        /** Expected time between heartbeats, or 0 for the longer of the loop time and sync timeout */
+        units::millisecond_t period = 0_ms;
+        /** A heartbeat older than this is late, or 0 for 1.5 periods */
+        units::millisecond_t deadline = 0_ms;
+        /** The enable drops once this many periods pass without a heartbeat */
+        int maxMissedCycles = 5;
+        /** How often the enable is fed */
+        units::millisecond_t feedPeriod = 5_ms;
+    };
+
+    /**
+     * Statistics of the supervisor.
+     */
+    struct Stats {
+        /** Number of times the enable was fed */
+        uint64_t feeds;
+        /** Heartbeats that were late but still within the missed-cycle threshold */
+        uint64_t nearMisses;
+        /** Number of times the enable was dropped because the heartbeats stopped */
+        uint64_t lapses;
+        /** Oldest heartbeat that the enable was still fed on */
+        units::millisecond_t worstAge;
+        /** Time between heartbeats, as seen by the supervisor */
+        LatencyHistogram::Summary interval;
+    };
+
+private:
+    Settings _settings{};
+    int _feedTimeoutMs = 20;
+
+    std::thread _thread;
+    std::atomic<bool> _running{false};
+
+    /* written by the robot loop */
+    std::atomic<int64_t> _heartbeatNs{0};
+    std::atomic<bool> _heartbeatEnabled{false};
+
+    /* written by the supervisor thread */
+    std::atomic<uint64_t> _feeds{0};
+    std::atomic<uint64_t> _nearMisses{0};
+    std::atomic<uint64_t> _lapses{0};
+    std::atomic<int64_t> _worstAgeNs{0};
+    std::atomic<int64_t> _lastLapseAgeNs{0};
+    LatencyHistogram _interval;
+
+public:
+    EnableSupervisor() = default;
+    ~EnableSupervisor() { Stop(); }
+
+    EnableSupervisor(EnableSupervisor const &) = delete;
+    EnableSupervisor &operator=(EnableSupervisor const &) = delete;
+
+    /**
+     * Starts feeding the enable on the supervisor thread, with
+     * the given settings and the loop's heartbeat period as the
+     * default period.
+     */
+    void Start(Settings settings, units::millisecond_t loopTime);
+
+    /**
+     * Stops the supervisor thread, letting the enable lapse.
+     */
+    void Stop();
+
+    /**
+     * Tells the supervisor the robot loop is alive, and whether
+     * the robot should be enabled. Call this every loop cycle.
+     */
+    void Heartbeat(bool enabled)
+    {
+        _heartbeatNs.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+        _heartbeatEnabled.store(enabled, std::memory_order_release);
+    }
+
+    /**
+     * Returns the number of times the enable was dropped
+     * because the heartbeats stopped. This is cheap enough to
+     * call every loop cycle.
+     */
+    uint64_t GetLapses() const { return _lapses.load(std::memory_order_relaxed); }
+
+    /**
+     * Returns the age of the heartbeat when the enable last dropped.
+     */
+    units::millisecond_t GetLastLapseAge() const
+    {
+        return units::millisecond_t{_lastLapseAgeNs.load(std::memory_order_relaxed) / 1e6};
+    }
+
+    /**
+     * Returns the statistics of the supervisor. This may be
+     * called from any thread.
+     */
+    Stats GetStats() const;
+
+private:
+    void Run();
+};
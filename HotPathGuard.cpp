@@ -0,0 +1,276 @@
+#include "HotPathGuard.hpp"
+#include "SingleWriter.hpp"
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <errno.h>
+#include <execinfo.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+/*static*/ thread_local HotPathGuard *HotPathGuard::t_guard = nullptr;
+
+/*static*/ void HotPathGuard::GetFrameName(void *frame, char *buffer, size_t size)
+{
+    Dl_info info{};
+    if (dladdr(frame, &info) == 0 || info.dli_fname == nullptr) {
+        snprintf(buffer, size, "%p", frame);
+        return;
+    }
+
+    /* the module offset can be given to addr2line, even for functions without a symbol */
+    char const *module = strrchr(info.dli_fname, '/');
+    module = module != nullptr ? module + 1 : info.dli_fname;
+    uintptr_t const offset = (uintptr_t)frame - (uintptr_t)info.dli_fbase;
+    if (info.dli_sname == nullptr) {
+        snprintf(buffer, size, "?? (%s+0x%zx)", module, (size_t)offset);
+        return;
+    }
+
+    int status = 0;
+    char *const demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+    snprintf(buffer, size, "%s+0x%zx (%s+0x%zx)", status == 0 ? demangled : info.dli_sname,
+            (size_t)((uintptr_t)frame - (uintptr_t)info.dli_saddr), module, (size_t)offset);
+    free(demangled);
+}
+
+#if ROBOT_HOT_PATH_GUARD
+
+namespace {
+
+long GetVoluntarySwitches()
+{
+    rusage usage;
+    getrusage(RUSAGE_THREAD, &usage);
+    return usage.ru_nvcsw;
+}
+
+}
+
+void HotPathGuard::SetMode(Mode mode, bool checkBlocking)
+{
+    if (mode != Mode::Off) {
+        /* the first backtrace loads the unwinder, so do not do that inside a scope */
+        void *frame;
+        backtrace(&frame, 1);
+    }
+    _mode = mode;
+    _checkBlocking = checkBlocking;
+}
+
+HotPathGuard::Stats HotPathGuard::GetStats() const
+{
+    return Stats{
+        _calls.load(std::memory_order_relaxed),
+        _allocations.load(std::memory_order_relaxed),
+        _blockingCalls.load(std::memory_order_relaxed),
+    };
+}
+
+HotPathGuard::Site const &HotPathGuard::GetSite(size_t index) const
+{
+    return _sites[index];
+}
+
+void HotPathGuard::PrintReport(FILE *file) const
+{
+    auto const stats = GetStats();
+    fprintf(file, "Hot path guard: %llu guarded calls, %llu heap allocations, %llu blocking calls\n",
+            (unsigned long long)stats.calls, (unsigned long long)stats.allocations,
+            (unsigned long long)stats.blockingCalls);
+
+    for (size_t i = 0; i < _numSites; ++i) {
+        Site const &site = _sites[i];
+        if (site.numFrames == 0) {
+            fprintf(file, "    %s blocked %llu times\n", site.scope, (unsigned long long)site.count);
+            continue;
+        }
+        fprintf(file, "    %llu heap allocations in %s, the first of %zu bytes, from:\n",
+                (unsigned long long)site.count, site.scope, site.size);
+        for (size_t f = 0; f < site.numFrames; ++f) {
+            char name[256];
+            GetFrameName(site.frames[f], name, sizeof(name));
+            fprintf(file, "        #%zu %s\n", f, name);
+        }
+    }
+    if (_numSites == kMaxSites) {
+        fprintf(file, "    Only the first %zu call sites were kept\n", kMaxSites);
+    }
+}
+
+bool HotPathGuard::Enter(char const *name)
+{
+    if (_mode == Mode::Off || _scope != nullptr) return false;
+
+    SingleWriterAdd(_calls);
+    if (_checkBlocking) {
+        _scopeSwitches = GetVoluntarySwitches();
+        _permittedSwitches = 0;
+    }
+    _scope = name;
+    return true;
+}
+
+void HotPathGuard::Exit()
+{
+    char const *const scope = _scope;
+    _scope = nullptr;
+
+    if (_checkBlocking && GetVoluntarySwitches() - _scopeSwitches > _permittedSwitches) {
+        RecordBlocking(scope);
+    }
+}
+
+void HotPathGuard::BeginPermit()
+{
+    if (_permits++ == 0 && _checkBlocking && _scope != nullptr) {
+        _permitSwitches = GetVoluntarySwitches();
+    }
+}
+
+void HotPathGuard::EndPermit()
+{
+    if (--_permits == 0 && _checkBlocking && _scope != nullptr) {
+        _permittedSwitches += GetVoluntarySwitches() - _permitSwitches;
+    }
+}
+
+__attribute__((noinline)) void HotPathGuard::RecordAllocation(size_t size)
+{
+    /* anything allocated from here on is the guard's own */
+    _handling = true;
+    SingleWriterAdd(_allocations);
+
+    /* skip this function and malloc */
+    constexpr size_t kSkippedFrames = 2;
+    void *frames[kMaxFrames + kSkippedFrames];
+    int const numFrames = backtrace(frames, kMaxFrames + kSkippedFrames);
+    size_t const numCallerFrames = numFrames > (int)kSkippedFrames ? numFrames - kSkippedFrames : 0;
+
+    if (_mode == Mode::Abort) {
+        fprintf(stderr, "Error: Heap allocation of %zu bytes in %s, from:\n", size, _scope);
+        backtrace_symbols_fd(frames + kSkippedFrames, numCallerFrames, STDERR_FILENO);
+        abort();
+    }
+
+    if (Site *site = FindSite(_scope, frames + kSkippedFrames, numCallerFrames)) {
+        if (site->count++ == 0) {
+            site->size = size;
+        }
+    }
+    _handling = false;
+}
+
+void HotPathGuard::RecordBlocking(char const *scope)
+{
+    SingleWriterAdd(_blockingCalls);
+
+    if (_mode == Mode::Abort) {
+        fprintf(stderr, "Error: %s blocked the thread\n", scope);
+        abort();
+    }
+
+    if (Site *site = FindSite(scope, nullptr, 0)) {
+        ++site->count;
+    }
+}
+
+HotPathGuard::Site *HotPathGuard::FindSite(char const *scope, void *const *frames, size_t numFrames)
+{
+    for (size_t i = 0; i < _numSites; ++i) {
+        Site &site = _sites[i];
+        if (site.scope == scope && site.numFrames == numFrames &&
+            (numFrames == 0 || memcmp(site.frames, frames, numFrames * sizeof(void *)) == 0)) {
+            return &site;
+        }
+    }
+    if (_numSites == kMaxSites) return nullptr;
+
+    Site &site = _sites[_numSites++];
+    site.scope = scope;
+    site.numFrames = numFrames;
+    if (numFrames > 0) {
+        memcpy(site.frames, frames, numFrames * sizeof(void *));
+    }
+    return &site;
+}
+
+/*
+ * Replaces the allocation functions of glibc for the whole
+ * program, forwarding to glibc's own. Its internal allocations
+ * (such as the buffers of stdio) and operator new all call these.
+ */
+extern "C" {
+
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+void *__libc_memalign(size_t alignment, size_t size);
+
+void *malloc(size_t size) noexcept
+{
+    HotPathGuard::OnAllocation(size);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) noexcept
+{
+    HotPathGuard::OnAllocation(count * size);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size) noexcept
+{
+    HotPathGuard::OnAllocation(size);
+    return __libc_realloc(ptr, size);
+}
+
+void *memalign(size_t alignment, size_t size) noexcept
+{
+    HotPathGuard::OnAllocation(size);
+    return __libc_memalign(alignment, size);
+}
+
+void *aligned_alloc(size_t alignment, size_t size) noexcept
+{
+    HotPathGuard::OnAllocation(size);
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void **result, size_t alignment, size_t size) noexcept
+{
+    if (alignment % sizeof(void *) != 0 || (alignment & (alignment - 1)) != 0) return EINVAL;
+
+    HotPathGuard::OnAllocation(size);
+    void *const ptr = __libc_memalign(alignment, size);
+    if (ptr == nullptr) return ENOMEM;
+    *result = ptr;
+    return 0;
+}
+
+}
+
+#else
+
+void HotPathGuard::SetMode(Mode mode, bool)
+{
+    if (mode != Mode::Off) {
+        fprintf(stderr, "Warning: The hot path guard needs a build with -DROBOT_HOT_PATH_GUARD=ON\n");
+    }
+}
+
+HotPathGuard::Stats HotPathGuard::GetStats() const
+{
+    return Stats{};
+}
+
+HotPathGuard::Site const &HotPathGuard::GetSite(size_t) const
+{
+    static Site const s_empty{};
+    return s_empty;
+}
+
+void HotPathGuard::PrintReport(FILE *) const {}
+
+#endif
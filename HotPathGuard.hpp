@@ -0,0 +1,254 @@
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/* set by the ROBOT_HOT_PATH_GUARD CMake option */
+#ifndef ROBOT_HOT_PATH_GUARD
+#define ROBOT_HOT_PATH_GUARD 0
+#endif
+
+/**
+ * Catches heap allocations, and optionally blocking, inside the
+ * periodic functions of the robot loop, where an innocent-looking
+ * std::string or printf can cost an occasional overrun.
+ *
+ * The guard interposes malloc, which also serves operator new,
+ * and checks a flag of the guarded thread that is set for the
+ * duration of each Scope. An allocation inside a scope records
+ * its call stack as a violation, or prints it and aborts, so a
+ * debugger or core dump shows the call site. With blocking checks,
+ * the voluntary context switches of the thread are counted across
+ * each scope, which catches any syscall that put the thread to
+ * sleep, such as a console write or a contended mutex, although
+ * only the scope it happened in is known.
+ *
+ * Code that allocates or waits on purpose, such as waiting for
+ * the CAN bus workers, can allow it with HOT_PATH_PERMIT().
+ *
+ * Only the thread that calls SetThreadGuard() is checked;
+ * RobotBase does this for the robot loop thread. When built
+ * without ROBOT_HOT_PATH_GUARD, the guard compiles to nothing
+ * and malloc is left alone. The guard replaces glibc's malloc,
+ * so it cannot be combined with a sanitizer.
+ */
+class HotPathGuard {
+public:
+    static constexpr size_t kMaxSites = 16;
+    static constexpr size_t kMaxFrames = 12;
+
+    enum class Mode {
+        Off,
+        /** Counts violations and keeps the call stack of each new one */
+        Report,
+        /** Prints the call stack of the first violation and aborts */
+        Abort,
+    };
+
+    /**
+     * A distinct place where the guard was violated.
+     */
+    struct Site {
+        /** The name of the scope it happened in */
+        char const *scope;
+        /** The return addresses of the allocation, innermost first, or none for blocking */
+        void *frames[kMaxFrames];
+        size_t numFrames;
+        /** The size of the first allocation */
+        size_t size;
+        /** How many times it happened */
+        uint64_t count;
+    };
+
+    struct Stats {
+        /** Guarded calls */
+        uint64_t calls;
+        /** Heap allocations in guarded calls */
+        uint64_t allocations;
+        /** Guarded calls that blocked the thread */
+        uint64_t blockingCalls;
+    };
+
+private:
+#if ROBOT_HOT_PATH_GUARD
+    Mode _mode = Mode::Off;
+    bool _checkBlocking = false;
+
+    /* owned by the guarded thread */
+    char const *_scope = nullptr;
+    int _permits = 0;
+    bool _handling = false;
+    long _scopeSwitches = 0;
+    long _permitSwitches = 0;
+    long _permittedSwitches = 0;
+
+    Site _sites[kMaxSites]{};
+    size_t _numSites = 0;
+
+    std::atomic<uint64_t> _calls{0};
+    std::atomic<uint64_t> _allocations{0};
+    std::atomic<uint64_t> _blockingCalls{0};
+#endif
+
+    static thread_local HotPathGuard *t_guard;
+
+public:
+    HotPathGuard() = default;
+
+    HotPathGuard(HotPathGuard const &) = delete;
+    HotPathGuard &operator=(HotPathGuard const &) = delete;
+
+    /**
+     * Returns the guard of the calling thread, or nullptr.
+     */
+    static HotPathGuard *GetThreadGuard() { return t_guard; }
+
+    /**
+     * Checks the scopes of the calling thread with the given
+     * guard, or stops checking them if nullptr.
+     */
+    static void SetThreadGuard(HotPathGuard *guard) { t_guard = guard; }
+
+    /**
+     * Sets how violations are handled, and whether blocking is
+     * checked as well as allocations. Call this from the guarded
+     * thread, outside of any scope.
+     */
+    void SetMode(Mode mode, bool checkBlocking = false);
+
+    /**
+     * Returns whether the guard is checking its scopes.
+     */
+    bool IsActive() const
+    {
+#if ROBOT_HOT_PATH_GUARD
+        return _mode != Mode::Off;
+#else
+        return false;
+#endif
+    }
+
+    /**
+     * Returns the number of guarded calls and violations.
+     * This may be called from any thread.
+     */
+    Stats GetStats() const;
+
+    /**
+     * Returns the number of distinct violations kept so far.
+     * Call this from the guarded thread.
+     */
+    size_t GetNumSites() const
+    {
+#if ROBOT_HOT_PATH_GUARD
+        return _numSites;
+#else
+        return 0;
+#endif
+    }
+
+    /**
+     * Returns the given violation, which must be less than
+     * GetNumSites(). Call this from the guarded thread.
+     */
+    Site const &GetSite(size_t index) const;
+
+    /**
+     * Writes the symbol and module offset of a return address
+     * to the buffer, such as for a line of a call stack.
+     * This allocates, so call it outside of any scope.
+     */
+    static void GetFrameName(void *frame, char *buffer, size_t size);
+
+    /**
+     * Prints the counts and call stacks of the violations.
+     * Call this from the guarded thread, outside of any scope.
+     */
+    void PrintReport(FILE *file = stdout) const;
+
+    /**
+     * Checks the rest of the enclosing scope on threads with an
+     * active guard. Scopes do not nest; an inner scope is part
+     * of the outer one.
+     */
+    class Scope {
+#if ROBOT_HOT_PATH_GUARD
+        HotPathGuard *const _guard = HotPathGuard::GetThreadGuard();
+        bool const _entered;
+
+    public:
+        explicit Scope(char const *name) : _entered{_guard != nullptr && _guard->Enter(name)} {}
+        ~Scope()
+        {
+            if (_entered) _guard->Exit();
+        }
+#else
+    public:
+        explicit constexpr Scope(char const *) {}
+#endif
+
+        Scope(Scope const &) = delete;
+        Scope &operator=(Scope const &) = delete;
+    };
+
+    /**
+     * Allows allocations and blocking for the rest of the
+     * enclosing scope. Use HOT_PATH_PERMIT().
+     */
+    class Permit {
+#if ROBOT_HOT_PATH_GUARD
+        HotPathGuard *const _guard = HotPathGuard::GetThreadGuard();
+
+    public:
+        Permit()
+        {
+            if (_guard != nullptr) _guard->BeginPermit();
+        }
+        ~Permit()
+        {
+            if (_guard != nullptr) _guard->EndPermit();
+        }
+#else
+    public:
+        constexpr Permit() {}
+#endif
+
+        Permit(Permit const &) = delete;
+        Permit &operator=(Permit const &) = delete;
+    };
+
+#if ROBOT_HOT_PATH_GUARD
+    /**
+     * Checks an allocation of the calling thread. Called by
+     * the interposed allocator.
+     */
+    static void OnAllocation(size_t size)
+    {
+        HotPathGuard *const guard = t_guard;
+        if (guard != nullptr && guard->_scope != nullptr && guard->_permits == 0 && !guard->_handling) {
+            guard->RecordAllocation(size);
+        }
+    }
+
+private:
+    bool Enter(char const *name);
+    void Exit();
+    void BeginPermit();
+    void EndPermit();
+    void RecordAllocation(size_t size);
+    void RecordBlocking(char const *scope);
+    /* returns the site matching the given frames, adding it if there is room */
+    Site *FindSite(char const *scope, void *const *frames, size_t numFrames);
+#endif
+};
+
+#define HOT_PATH_CONCAT_INNER(a, b) a##b
+#define HOT_PATH_CONCAT(a, b) HOT_PATH_CONCAT_INNER(a, b)
+
+/**
+ * Allows allocations and blocking in the rest of the enclosing
+ * scope, for code in the robot loop that does either on purpose.
+ */
+#define HOT_PATH_PERMIT() HotPathGuard::Permit const HOT_PATH_CONCAT(hotPathPermit, __LINE__){}
@@ -0,0 +1,188 @@
+#pragma once
+
+#include "InputThread.hpp"
+#include "NetworkInput.hpp"
+#include "SeqLock.hpp"
+#include <SDL2/SDL.h>
+#include <array>
+#include <memory>
+
+/**
+ * Logical controller buttons, mapped to device buttons by
+ * each input backend at compile time.
+ */
+enum class InputButton {
+    A, B, X, Y,
+    LeftShoulder, RightShoulder,
+    Back, Start, Guide,
+    LeftStick, RightStick,
+};
+static constexpr size_t kNumInputButtons = 11;
+
+/**
+ * Logical controller axes, mapped to device axes by each
+ * input backend at compile time.
+ */
+enum class InputAxis {
+    LeftX, LeftY,
+    RightX, RightY,
+    LeftTrigger, RightTrigger,
+};
+static constexpr size_t kNumInputAxes = 6;
+
+/**
+ * Base of the backends that read devices through the shared
+ * InputThread, which owns the SDL library for all of them.
+ */
+template <InputThread::DeviceKind Kind>
+class SdlBackend {
+private:
+    std::shared_ptr<InputThread> _input;
+    SeqLock<InputState> const *_source;
+
+public:
+    explicit SdlBackend(int port) :
+        _input{InputThread::Acquire()},
+        _source{&_input->Subscribe(port, Kind)}
+    {}
+
+    /** Copies out the latest state of the device. */
+    void Read(InputState &state) const
+    {
+        _source->Load(state);
+    }
+};
+
+/**
+ * Reads a raw SDL joystick. The mappings match an Xbox
+ * controller as the example robot has always read it.
+ *
+ * Note: This is the legacy backend for users on Ubuntu
+ *       20.04 and older.
+ */
+class JoystickBackend : public SdlBackend<InputThread::DeviceKind::Joystick> {
+public:
+    using SdlBackend::SdlBackend;
+
+    using Type = SDL_JoystickType;
+    static constexpr Type kUnknownType = SDL_JOYSTICK_TYPE_UNKNOWN;
+
+    static constexpr std::array<int, kNumInputButtons> kButtonMap{
+        0, 1, 2, 3, // A, B, X, Y
+        4, 5, // LeftShoulder, RightShoulder
+        6, 7, 8, // Back, Start, Guide
+        9, 10, // LeftStick, RightStick
+    };
+    static constexpr std::array<int, kNumInputAxes> kAxisMap{
+        0, 1, // LeftX, LeftY
+        4, 3, // RightX, RightY
+        2, 5, // LeftTrigger, RightTrigger
+    };
+};
+
+/**
+ * Reads an SDL game controller, which SDL maps to a standard
+ * layout regardless of the device.
+ *
+ * Note: SDL reports the controller type from SDL 2.0.12 on
+ *       (Ubuntu 22.04+ or Debian Bullseye); with older SDL,
+ *       GetType() always returns the unknown type.
+ */
+class GameControllerBackend : public SdlBackend<InputThread::DeviceKind::GameController> {
+public:
+    using SdlBackend::SdlBackend;
+
+#if SDL_VERSION_ATLEAST(2, 0, 12)
+    using Type = SDL_GameControllerType;
+    static constexpr Type kUnknownType = SDL_CONTROLLER_TYPE_UNKNOWN;
+#else
+    using Type = int;
+    static constexpr Type kUnknownType = 0;
+#endif
+
+    static constexpr std::array<int, kNumInputButtons> kButtonMap{
+        SDL_CONTROLLER_BUTTON_A, SDL_CONTROLLER_BUTTON_B, SDL_CONTROLLER_BUTTON_X, SDL_CONTROLLER_BUTTON_Y,
+        SDL_CONTROLLER_BUTTON_LEFTSHOULDER, SDL_CONTROLLER_BUTTON_RIGHTSHOULDER,
+        SDL_CONTROLLER_BUTTON_BACK, SDL_CONTROLLER_BUTTON_START, SDL_CONTROLLER_BUTTON_GUIDE,
+        SDL_CONTROLLER_BUTTON_LEFTSTICK, SDL_CONTROLLER_BUTTON_RIGHTSTICK,
+    };
+    static constexpr std::array<int, kNumInputAxes> kAxisMap{
+        SDL_CONTROLLER_AXIS_LEFTX, SDL_CONTROLLER_AXIS_LEFTY,
+        SDL_CONTROLLER_AXIS_RIGHTX, SDL_CONTROLLER_AXIS_RIGHTY,
+        SDL_CONTROLLER_AXIS_TRIGGERLEFT, SDL_CONTROLLER_AXIS_TRIGGERRIGHT,
+    };
+};
+
+/**
+ * A device whose state is set by the program, such as a test,
+ * a simulation or a scripted input source. It uses the game
+ * controller layout and never touches SDL.
+ */
+class VirtualBackend {
+private:
+    SeqLock<InputState> _source{};
+
+public:
+    explicit VirtualBackend(int /*port*/) {}
+
+    using Type = int;
+    static constexpr Type kUnknownType = 0;
+
+    static constexpr auto kButtonMap = GameControllerBackend::kButtonMap;
+    static constexpr auto kAxisMap = GameControllerBackend::kAxisMap;
+
+    /** Copies out the latest state of the device. */
+    void Read(InputState &state) const
+    {
+        _source.Load(state);
+    }
+
+    /**
+     * Sets the state of the device. Only one thread may set
+     * the state of a given device.
+     */
+    void Set(InputState const &state)
+    {
+        _source.Store(state);
+    }
+};
+
+/**
+ * Receives a controller from a remote operator station over
+ * UDP through the shared NetworkInput thread. The controller
+ * reads as disconnected when its packets stop, so losing the
+ * network disables the robot. It uses the game controller
+ * layout, which InputSender sends.
+ */
+class NetworkBackend {
+private:
+    std::shared_ptr<NetworkInput> _input;
+    int _port;
+
+public:
+    explicit NetworkBackend(int port) :
+        _input{NetworkInput::Acquire()},
+        _port{port}
+    {}
+
+    using Type = int;
+    static constexpr Type kUnknownType = 0;
+
+    static constexpr auto kButtonMap = GameControllerBackend::kButtonMap;
+    static constexpr auto kAxisMap = GameControllerBackend::kAxisMap;
+
+    /** Copies out the latest state of the device. */
+    void Read(InputState &state) const
+    {
+        _input->Read(_port, state);
+    }
+
+    /**
+     * Returns the latency and loss statistics of the network
+     * input. This may be called from any thread.
+     */
+    NetworkInput::Stats GetStats() const
+    {
+        return _input->GetStats();
+    }
+};
@@ -0,0 +1,99 @@
+#include "GameController.hpp"
+#include "Joystick.hpp"
+#include "LatencyHistogram.hpp"
+#include <stdlib.h>
+
+namespace {
+
+/**
+ * Times the input work the example robot does every loop,
+ * split by whether the device is connected.
+ */
+template <typename Backend>
+class InputWorkload {
+private:
+    InputDevice<Backend> _device{0};
+    bool _wasConnected = _device.IsConnected();
+
+public:
+    char const *const name;
+    LatencyHistogram connected;
+    LatencyHistogram disconnected;
+    uint64_t transitions = 0;
+    double sink = 0;
+
+    explicit InputWorkload(char const *name) : name{name} {}
+
+    void RunCycle()
+    {
+        auto const start = std::chrono::steady_clock::now();
+
+        _device.Periodic();
+        auto const &input = _device.Snapshot();
+        if (input.numAxes >= 6 && input.GetButton(InputDevice<Backend>::MapButton(InputButton::RightShoulder))) {
+            sink += _device.template GetAxis<InputAxis::LeftY>() + _device.template GetAxis<InputAxis::RightX>();
+        }
+
+        auto const dt = std::chrono::steady_clock::now() - start;
+        if (_device.IsConnected()) {
+            connected.Record(dt);
+        } else {
+            disconnected.Record(dt);
+        }
+        if (_device.IsConnected() != _wasConnected) {
+            _wasConnected = _device.IsConnected();
+            ++transitions;
+        }
+    }
+
+    void Print() const
+    {
+        for (auto const &[state, hist] : {std::pair{"connected", &connected}, std::pair{"disconnected", &disconnected}}) {
+            auto const summary = hist->GetSummary();
+            printf("%-15s %-13s %10llu %10.3f %10.3f %10.3f %10.3f %10.3f\n",
+                    name, state, (unsigned long long)summary.count,
+                    summary.min.value(), summary.p50.value(), summary.p99.value(),
+                    summary.p999.value(), summary.max.value());
+        }
+        printf("%-15s connection changes: %llu\n", name, (unsigned long long)transitions);
+    }
+};
+
+}
+
+/**
+ * Measures what the robot loop pays for input handling each
+ * cycle with each SDL backend, split by whether the device is
+ * connected. Run it with no controller plugged in, or plug
+ * and unplug one while it runs, to see the worst-case cost
+ * while disconnected.
+ *
+ * Usage: ./InputBenchmark [duration in seconds (default: 10)]
+ */
+int main(int argc, char **argv)
+{
+    int const durationS = argc > 1 ? atoi(argv[1]) : 10;
+    constexpr auto kPeriod = std::chrono::milliseconds{1};
+
+    InputWorkload<JoystickBackend> joystick{"Joystick"};
+    InputWorkload<GameControllerBackend> gameController{"GameController"};
+
+    printf("Measuring input handling for %d s...\n", durationS);
+
+    auto const end = std::chrono::steady_clock::now() + std::chrono::seconds{durationS};
+    auto deadline = std::chrono::steady_clock::now();
+    while (deadline < end) {
+        joystick.RunCycle();
+        gameController.RunCycle();
+
+        deadline += kPeriod;
+        std::this_thread::sleep_until(deadline);
+    }
+
+    printf("%-15s %-13s %10s %10s %10s %10s %10s %10s\n",
+            "Input (us)", "", "cycles", "min", "p50", "p99", "p99.9", "max");
+    joystick.Print();
+    gameController.Print();
+
+    return joystick.sink + gameController.sink > 1e300;
+}
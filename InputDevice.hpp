@@ -0,0 +1,251 @@
+#pragma once
+
+#include "InputBackends.hpp"
+#include "InputSnapshot.hpp"
+#include <SDL2/SDL.h>
+#include <stdint.h>
+#include <string>
+
+/**
+ * Manages an input device, reading it through the given
+ * backend once per Periodic() call. All getters read the
+ * resulting snapshot from plain memory, and the backend's
+ * button and axis mappings are resolved at compile time.
+ *
+ * Backends provide Read(InputState &), a Type for GetType(),
+ * kUnknownType, and kButtonMap/kAxisMap arrays indexed by
+ * InputButton/InputAxis. See InputBackends.hpp.
+ */
+template <typename Backend>
+class InputDevice {
+private:
+    Backend _backend;
+    InputState _state{};
+    InputState const *_stateSource = nullptr;
+    InputShaper _shaper{};
+    InputSnapshot _snapshot{};
+    InputSnapshot _previous{};
+    int _port;
+
+public:
+    /**
+     * Returns the device button of the given logical button.
+     */
+    static constexpr int MapButton(InputButton button)
+    {
+        return Backend::kButtonMap[(size_t)button];
+    }
+
+    /**
+     * Returns the device axis of the given logical axis.
+     */
+    static constexpr int MapAxis(InputAxis axis)
+    {
+        return Backend::kAxisMap[(size_t)axis];
+    }
+
+    /**
+     * Creates an input device on the given port.
+     */
+    explicit InputDevice(int port) : _backend{port}, _port{port}
+    {
+        /* start with whatever the backend has */
+        Periodic();
+    }
+
+    /**
+     * Returns the backend of this device, such as to
+     * set the state of a VirtualBackend.
+     */
+    Backend &GetBackend() { return _backend; }
+
+    /**
+     * Returns the raw state read by the last call to Periodic().
+     */
+    InputState const &GetRawState() const { return _state; }
+
+    /**
+     * Reads the raw state from the given memory instead of the
+     * backend, such as to replay a recording. Pass nullptr to
+     * read from the backend again.
+     */
+    void SetStateSource(InputState const *source) { _stateSource = source; }
+
+    /**
+     * Returns the port of this device.
+     */
+    int GetPort() const { return _port; }
+
+    /**
+     * Returns the name of this device.
+     */
+    std::string GetName() const
+    {
+        if (_state.connected) {
+            return _state.name;
+        } else {
+            return "";
+        }
+    }
+
+    /**
+     * Returns the backend's type of this device.
+     */
+    typename Backend::Type GetType() const
+    {
+        if (_state.connected) {
+            return (typename Backend::Type)_state.type;
+        } else {
+            return Backend::kUnknownType;
+        }
+    }
+
+    /**
+     * Returns the number of buttons on this device.
+     */
+    int GetNumButtons() const
+    {
+        if (_state.connected) {
+            return _state.numButtons;
+        } else {
+            return -1;
+        }
+    }
+
+    /**
+     * Returns the number of axes on this device.
+     */
+    int GetNumAxes() const
+    {
+        if (_state.connected) {
+            return _state.numAxes;
+        } else {
+            return -1;
+        }
+    }
+
+    /**
+     * Returns the number of hats on this device.
+     */
+    int GetNumHats() const
+    {
+        if (_state.connected) {
+            return _state.numHats;
+        } else {
+            return -1;
+        }
+    }
+
+    /**
+     * Returns the snapshot of this device taken by the last
+     * call to Periodic(). Reading input through the snapshot
+     * avoids a function call and range check per value.
+     */
+    InputSnapshot const &Snapshot() const { return _snapshot; }
+
+    /**
+     * Returns the snapshot taken by the call to Periodic()
+     * before the last one, for detecting changes.
+     */
+    InputSnapshot const &PreviousSnapshot() const { return _previous; }
+
+    /**
+     * Sets the deadband and expo applied to the given device axis.
+     * See InputShaper::SetAxis() for details.
+     */
+    void SetAxisShaping(int axis, double deadband, double expo = 0.0)
+    {
+        _shaper.SetAxis(axis, deadband, expo);
+    }
+
+    /**
+     * Returns true if the given device button is pressed,
+     * false otherwise or in the case of an error.
+     */
+    bool GetButton(int button) const
+    {
+        return _snapshot.GetButton(button);
+    }
+
+    /**
+     * Returns true if the given logical button is pressed,
+     * false otherwise or in the case of an error.
+     */
+    template <InputButton B>
+    bool GetButton() const
+    {
+        return _snapshot.GetButton(MapButton(B));
+    }
+
+    /**
+     * Returns true if the given device button was pressed
+     * since the previous call to Periodic().
+     */
+    bool GetButtonPressed(int button) const
+    {
+        return _snapshot.GetButton(button) && !_previous.GetButton(button);
+    }
+
+    /**
+     * Returns true if the given device button was released
+     * since the previous call to Periodic().
+     */
+    bool GetButtonReleased(int button) const
+    {
+        return !_snapshot.GetButton(button) && _previous.GetButton(button);
+    }
+
+    /**
+     * Returns the value of the given device axis from
+     * -1.0 to 1.0 after shaping, or 0 in the case of an error.
+     */
+    double GetAxis(int axis) const
+    {
+        return _snapshot.GetAxis(axis);
+    }
+
+    /**
+     * Returns the value of the given logical axis from
+     * -1.0 to 1.0 after shaping, or 0 in the case of an error.
+     */
+    template <InputAxis A>
+    double GetAxis() const
+    {
+        return _snapshot.GetAxis(MapAxis(A));
+    }
+
+    /**
+     * Returns the value of the given device hat as SDL_HAT_*
+     * flags, or SDL_HAT_CENTERED in the case of an error.
+     */
+    uint8_t GetHat(int hat) const
+    {
+        if (_state.connected && hat >= 0 && hat < InputState::kMaxHats) {
+            return _state.hats[hat];
+        } else {
+            return SDL_HAT_CENTERED;
+        }
+    }
+
+    /**
+     * Returns whether this device is currently connected.
+     */
+    bool IsConnected() const { return _state.connected; }
+
+    /**
+     * Periodically updates this device with the latest state
+     * from its backend. Call this once per robot loop, before
+     * reading the device.
+     */
+    void Periodic()
+    {
+        if (_stateSource != nullptr) {
+            _state = *_stateSource;
+        } else {
+            _backend.Read(_state);
+        }
+
+        _previous = _snapshot;
+        _shaper.Apply(_state, _snapshot);
+    }
+};
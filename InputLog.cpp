@@ -0,0 +1,167 @@
+#include "InputLog.hpp"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+bool InputRecorder::Open(char const *path, size_t numInputs, units::microsecond_t loopTime, units::second_t expectedDuration)
+{
+    Close();
+
+    _fd = open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (_fd < 0) {
+        fprintf(stderr, "Error: Could not create recording %s: %s\n", path, strerror(errno));
+        return false;
+    }
+
+    _numInputs = numInputs;
+    _recordSize = InputLog::RecordSize(numInputs);
+    _end = sizeof(InputLog::Header);
+
+    /* allocate the blocks of the expected run now, rather than on the first write to each page */
+    size_t const pageSize = sysconf(_SC_PAGESIZE);
+    size_t const expectedRecords = (size_t)(expectedDuration.value() / units::second_t{loopTime}.value()) + 1;
+    size_t const size = (_end + expectedRecords * _recordSize + pageSize - 1) / pageSize * pageSize;
+    int const error = posix_fallocate(_fd, 0, size);
+    if (error != 0) {
+        fprintf(stderr, "Error: Could not allocate recording %s: %s\n", path, strerror(error));
+        Close();
+        return false;
+    }
+    if (!Grow(size)) {
+        fprintf(stderr, "Error: Could not map recording %s: %s\n", path, strerror(errno));
+        Close();
+        return false;
+    }
+
+    InputLog::Header header{};
+    memcpy(header.magic, InputLog::kMagic, sizeof(header.magic));
+    header.version = InputLog::kVersion;
+    header.recordSize = _recordSize;
+    header.numInputs = numInputs;
+    header.loopTimeUs = loopTime.value();
+    header.numRecords = 0;
+    memcpy(_map, &header, sizeof(header));
+
+    return true;
+}
+
+void InputRecorder::Close()
+{
+    if (_map != nullptr) {
+        munmap(_map, _mapSize);
+        _map = nullptr;
+        _mapSize = 0;
+    }
+    if (_fd >= 0) {
+        /* drop the unused part of the last chunk */
+        if (ftruncate(_fd, _end) != 0) {
+            fprintf(stderr, "Warning: Could not trim recording: %s\n", strerror(errno));
+        }
+        close(_fd);
+        _fd = -1;
+    }
+}
+
+void InputRecorder::Write(std::chrono::nanoseconds timestamp, bool enabled, InputState const *const *inputs)
+{
+    if (_map == nullptr) return;
+    if (_end + _recordSize > _mapSize && !Grow(_mapSize + kChunkSize)) {
+        fprintf(stderr, "Error: Could not grow recording, stopping: %s\n", strerror(errno));
+        Close();
+        return;
+    }
+
+    auto *data = _map + _end;
+    auto *record = reinterpret_cast<InputLog::RecordHeader *>(data);
+    record->timestampNs = timestamp.count();
+    record->enabled = enabled;
+    for (size_t i = 0; i < _numInputs; ++i) {
+        memcpy(data + sizeof(InputLog::RecordHeader) + i * sizeof(InputState), inputs[i], sizeof(InputState));
+    }
+    _end += _recordSize;
+
+    /* publish the record only once it is complete */
+    reinterpret_cast<InputLog::Header *>(_map)->numRecords += 1;
+}
+
+bool InputRecorder::Grow(size_t newSize)
+{
+    /* the file is sparse past the expected run, so only the pages that are written take up space */
+    if (ftruncate(_fd, newSize) != 0) return false;
+
+    void *map;
+    if (_map == nullptr) {
+        /* fault the whole mapping in now, so the loop never takes a page fault on it */
+        map = mmap(nullptr, newSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, 0);
+    } else {
+        map = mremap(_map, _mapSize, newSize, MREMAP_MAYMOVE);
+    }
+    if (map == MAP_FAILED) return false;
+
+    _map = static_cast<uint8_t *>(map);
+    _mapSize = newSize;
+    return true;
+}
+
+bool InputReplayer::Open(char const *path)
+{
+    Close();
+
+    int const fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        fprintf(stderr, "Error: Could not open recording %s: %s\n", path, strerror(errno));
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(InputLog::Header)) {
+        fprintf(stderr, "Error: %s is not a recording\n", path);
+        close(fd);
+        return false;
+    }
+
+    void *map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "Error: Could not map recording %s: %s\n", path, strerror(errno));
+        return false;
+    }
+    _map = static_cast<uint8_t const *>(map);
+    _mapSize = st.st_size;
+
+    memcpy(&_header, _map, sizeof(_header));
+    if (memcmp(_header.magic, InputLog::kMagic, sizeof(_header.magic)) != 0 ||
+        _header.version != InputLog::kVersion ||
+        _header.recordSize != InputLog::RecordSize(_header.numInputs))
+    {
+        fprintf(stderr, "Error: %s is not a recording of this version\n", path);
+        Close();
+        return false;
+    }
+
+    /* a killed recorder leaves its last chunk untrimmed, so trust the header over the file size */
+    size_t const available = (_mapSize - sizeof(InputLog::Header)) / _header.recordSize;
+    if (_header.numRecords > available) {
+        fprintf(stderr, "Warning: %s is truncated, replaying %zu of %llu cycles\n",
+                path, available, (unsigned long long)_header.numRecords);
+        _header.numRecords = available;
+    }
+
+    /* replay reads straight through */
+    madvise(map, _mapSize, MADV_SEQUENTIAL);
+    return true;
+}
+
+void InputReplayer::Close()
+{
+    if (_map != nullptr) {
+        munmap(const_cast<uint8_t *>(_map), _mapSize);
+        _map = nullptr;
+        _mapSize = 0;
+    }
+    _header = InputLog::Header{};
+}
@@ -0,0 +1,155 @@
+#pragma once
+
+#include "InputThread.hpp"
+#include "units/time.h"
+#include <chrono>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * The binary format of a recorded robot program: a header,
+ * followed by one fixed-size record per robot loop cycle.
+ * Each record holds the cycle's timestamp, whether the robot
+ * was enabled, and the raw state of every logged input.
+ */
+namespace InputLog {
+    static constexpr char kMagic[8] = {'P', '6', 'I', 'N', 'L', 'O', 'G', '\0'};
+    static constexpr uint32_t kVersion = 1;
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        /** Size of each record, including its inputs */
+        uint32_t recordSize;
+        uint32_t numInputs;
+        uint32_t loopTimeUs;
+        /** Number of complete records, updated after every record */
+        uint64_t numRecords;
+    };
+
+    struct RecordHeader {
+        /** Time of the cycle since the robot loop started */
+        int64_t timestampNs;
+        uint8_t enabled;
+        uint8_t reserved[7];
+        /* followed by numInputs InputStates */
+    };
+
+    /** Returns the size of a record with the given number of inputs. */
+    constexpr size_t RecordSize(size_t numInputs)
+    {
+        /* keep every record 8-byte aligned */
+        return (sizeof(RecordHeader) + numInputs * sizeof(InputState) + 7) & ~(size_t)7;
+    }
+}
+
+/**
+ * Records robot loop cycles to a memory-mapped file. The file
+ * is allocated and mapped for the expected length of the run
+ * when it is opened, so writing a record is only a copy into
+ * memory that is already there. A longer run grows the file
+ * in large chunks, which stalls the cycle that grows it.
+ * The record count in the header is updated after every
+ * record, so the file stays valid if the program is killed.
+ */
+class InputRecorder {
+private:
+    static constexpr size_t kChunkSize = 16 << 20;
+
+    int _fd = -1;
+    uint8_t *_map = nullptr;
+    size_t _mapSize = 0;
+    size_t _recordSize = 0;
+    size_t _numInputs = 0;
+    size_t _end = 0;
+
+public:
+    InputRecorder() = default;
+    ~InputRecorder() { Close(); }
+
+    InputRecorder(InputRecorder const &) = delete;
+    InputRecorder &operator=(InputRecorder const &) = delete;
+
+    /**
+     * Creates the recording file, replacing any existing one,
+     * with room for the records of the expected duration.
+     * Returns false and prints the error on failure.
+     */
+    bool Open(char const *path, size_t numInputs, units::microsecond_t loopTime, units::second_t expectedDuration);
+
+    /**
+     * Trims the file to the recorded data and closes it.
+     */
+    void Close();
+
+    /**
+     * Returns whether a recording is open.
+     */
+    bool IsOpen() const { return _map != nullptr; }
+
+    /**
+     * Appends a record of one cycle, with the state of each
+     * of the inputs given to Open().
+     */
+    void Write(std::chrono::nanoseconds timestamp, bool enabled, InputState const *const *inputs);
+
+private:
+    bool Grow(size_t newSize);
+};
+
+/**
+ * Reads a recording made by InputRecorder through a read-only
+ * memory mapping.
+ */
+class InputReplayer {
+public:
+    /**
+     * One recorded cycle, pointing into the mapping.
+     */
+    struct Record {
+        std::chrono::nanoseconds timestamp;
+        bool enabled;
+        InputState const *inputs;
+    };
+
+private:
+    uint8_t const *_map = nullptr;
+    size_t _mapSize = 0;
+    InputLog::Header _header{};
+
+public:
+    InputReplayer() = default;
+    ~InputReplayer() { Close(); }
+
+    InputReplayer(InputReplayer const &) = delete;
+    InputReplayer &operator=(InputReplayer const &) = delete;
+
+    /**
+     * Opens a recording. Returns false and prints the error
+     * if it cannot be opened or is not a valid recording.
+     */
+    bool Open(char const *path);
+
+    /**
+     * Closes the recording.
+     */
+    void Close();
+
+    size_t GetNumRecords() const { return _header.numRecords; }
+    size_t GetNumInputs() const { return _header.numInputs; }
+    units::microsecond_t GetLoopTime() const { return units::microsecond_t{(double)_header.loopTimeUs}; }
+
+    /**
+     * Returns the given record, which must be less than GetNumRecords().
+     */
+    Record GetRecord(size_t index) const
+    {
+        auto const *data = _map + sizeof(InputLog::Header) + index * _header.recordSize;
+        auto const *header = reinterpret_cast<InputLog::RecordHeader const *>(data);
+        return Record{
+            std::chrono::nanoseconds{header->timestampNs},
+            header->enabled != 0,
+            reinterpret_cast<InputState const *>(data + sizeof(InputLog::RecordHeader)),
+        };
+    }
+};
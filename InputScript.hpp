@@ -0,0 +1,75 @@
+#pragma once
+
+#include "InputThread.hpp"
+#include "units/time.h"
+#include <initializer_list>
+#include <utility>
+#include <vector>
+#include <stdint.h>
+
+/**
+ * A scripted input device for simulation: a timeline of
+ * states, each held from its start time until the next.
+ */
+class InputScript {
+private:
+    struct Step {
+        units::second_t time;
+        InputState state;
+    };
+
+    std::vector<Step> _steps;
+    size_t _current = 0;
+
+public:
+    /**
+     * Returns the state of a connected gamepad with the given
+     * device buttons pressed and device axes from -1.0 to 1.0.
+     */
+    static InputState Gamepad(std::initializer_list<int> buttons, std::initializer_list<std::pair<int, double>> axes,
+                              int numAxes = 6, int numButtons = 11)
+    {
+        InputState state{};
+        state.connected = true;
+        state.numAxes = numAxes;
+        state.numButtons = numButtons;
+        state.numHats = 1;
+        for (int button : buttons) {
+            if (button >= 0 && button < InputState::kMaxButtons) {
+                state.buttons |= 1u << button;
+            }
+        }
+        for (auto const &[axis, value] : axes) {
+            if (axis >= 0 && axis < InputState::kMaxAxes) {
+                state.axes[axis] = (int16_t)(value >= 0 ? value * 32767 : value * 32768);
+            }
+        }
+        return state;
+    }
+
+    /**
+     * Holds the given state from the given time on. Steps
+     * must be added in order of time.
+     */
+    InputScript &At(units::second_t time, InputState const &state)
+    {
+        _steps.push_back(Step{time, state});
+        return *this;
+    }
+
+    /**
+     * Copies the state at the given time, or a disconnected
+     * device before the first step. Time must not go backwards.
+     */
+    void Apply(units::second_t time, InputState &state)
+    {
+        while (_current < _steps.size() && _steps[_current].time <= time) {
+            ++_current;
+        }
+        if (_current == 0) {
+            state = InputState{};
+        } else {
+            state = _steps[_current - 1].state;
+        }
+    }
+};
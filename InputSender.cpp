@@ -0,0 +1,204 @@
+#include "GameController.hpp"
+#include "InputScript.hpp"
+#include "NetworkInput.hpp"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/ip.h>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace {
+
+/**
+ * Sends packets to the robot, optionally dropping and
+ * reordering some of them to exercise the receiver.
+ */
+class Sender {
+private:
+    int _socket;
+    sockaddr_in _address{};
+    double _dropRate;
+    double _reorderRate;
+
+    std::mt19937 _random{std::random_device{}()};
+    std::uniform_real_distribution<double> _chance{0.0, 1.0};
+    uint32_t const _session = _random();
+    uint32_t _sequence = 0;
+
+    NetworkInput::Packet _held{};
+    bool _holding = false;
+
+public:
+    uint64_t sent = 0;
+    uint64_t dropped = 0;
+    uint64_t reordered = 0;
+
+    Sender(int socket, sockaddr_in const &address, double dropRate, double reorderRate) :
+        _socket{socket}, _address{address}, _dropRate{dropRate}, _reorderRate{reorderRate}
+    {}
+
+    void Send(int port, InputState const &state)
+    {
+        timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+
+        NetworkInput::Packet packet{};
+        packet.magic = NetworkInput::kMagic;
+        packet.version = NetworkInput::kVersion;
+        packet.port = port;
+        packet.connected = state.connected;
+        packet.session = _session;
+        packet.sequence = ++_sequence;
+        packet.sendTimeNs = (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+        memcpy(packet.axes, state.axes, sizeof(packet.axes));
+        packet.buttons = state.buttons;
+        memcpy(packet.hats, state.hats, sizeof(packet.hats));
+        packet.numAxes = state.numAxes;
+        packet.numButtons = state.numButtons;
+        packet.numHats = state.numHats;
+
+        if (_chance(_random) < _dropRate) {
+            ++dropped;
+            return;
+        }
+        if (!_holding && _chance(_random) < _reorderRate) {
+            /* send this one after the next */
+            _held = packet;
+            _holding = true;
+            ++reordered;
+            return;
+        }
+        Write(packet);
+        if (_holding) {
+            Write(_held);
+            _holding = false;
+        }
+    }
+
+private:
+    void Write(NetworkInput::Packet const &packet)
+    {
+        if (sendto(_socket, &packet, sizeof(packet), 0, (sockaddr const *)&_address, sizeof(_address)) < 0) {
+            fprintf(stderr, "Error: Could not send network input: %s\n", strerror(errno));
+            return;
+        }
+        ++sent;
+    }
+};
+
+}
+
+/**
+ * Sends a controller to a robot program built with the Network
+ * input backend, at a fixed rate over UDP.
+ *
+ * By default, this reads the local game controller. With --test,
+ * it sends a scripted controller instead, holding the enable
+ * button and driving forward, then arcing, for the given time,
+ * then stops sending so the robot sees the link drop. --drop and
+ * --reorder lose or swap that fraction of the packets.
+ *
+ * Usage: ./InputSender [--host <address>] [--port <udp port>] [--rate <hz>] [--controller <port>]
+ *                      [--test <seconds>] [--drop <fraction>] [--reorder <fraction>]
+ */
+int main(int argc, char **argv)
+{
+    char const *host = "127.0.0.1";
+    int udpPort = NetworkInput::kDefaultUdpPort;
+    double rateHz = 200;
+    int controllerPort = 0;
+    double testSeconds = 0;
+    double dropRate = 0;
+    double reorderRate = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--host") == 0 && i + 1 < argc) {
+            host = argv[++i];
+        } else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            udpPort = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--rate") == 0 && i + 1 < argc) {
+            rateHz = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--controller") == 0 && i + 1 < argc) {
+            controllerPort = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--test") == 0 && i + 1 < argc) {
+            testSeconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--drop") == 0 && i + 1 < argc) {
+            dropRate = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--reorder") == 0 && i + 1 < argc) {
+            reorderRate = atof(argv[++i]);
+        } else {
+            fprintf(stderr, "Usage: %s [--host <address>] [--port <udp port>] [--rate <hz>] [--controller <port>]\n"
+                    "       [--test <seconds>] [--drop <fraction>] [--reorder <fraction>]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (rateHz <= 0 || controllerPort < 0 || controllerPort >= NetworkInput::kMaxPorts) {
+        fprintf(stderr, "Error: Invalid rate or controller port\n");
+        return 1;
+    }
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(udpPort);
+    if (inet_pton(AF_INET, host, &address.sin_addr) != 1) {
+        fprintf(stderr, "Error: %s is not an IPv4 address\n", host);
+        return 1;
+    }
+    int const fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        fprintf(stderr, "Error: Could not create a socket: %s\n", strerror(errno));
+        return 1;
+    }
+    /* mark the packets as latency-sensitive for the network */
+    int const lowDelay = IPTOS_LOWDELAY;
+    setsockopt(fd, IPPROTO_IP, IP_TOS, &lowDelay, sizeof(lowDelay));
+
+    Sender sender{fd, address, dropRate, reorderRate};
+
+    /* the scripted controller uses the game controller layout, like the network backend */
+    constexpr int kEnable = SDL_CONTROLLER_BUTTON_RIGHTSHOULDER;
+    constexpr int kSpeed = SDL_CONTROLLER_AXIS_LEFTY;
+    constexpr int kTurn = SDL_CONTROLLER_AXIS_RIGHTX;
+    InputScript script;
+    script.At(0_s, InputScript::Gamepad({kEnable}, {{kSpeed, -0.3}}))
+        .At(units::second_t{testSeconds / 2}, InputScript::Gamepad({kEnable}, {{kSpeed, -0.3}, {kTurn, 0.2}}));
+
+    std::unique_ptr<GameController> controller;
+    if (testSeconds > 0) {
+        printf("Sending a scripted controller to %s:%d for %.1f s at %.0f Hz...\n", host, udpPort, testSeconds, rateHz);
+    } else {
+        controller = std::make_unique<GameController>(0);
+        printf("Sending game controller 0 to %s:%d at %.0f Hz, press Ctrl-C to stop...\n", host, udpPort, rateHz);
+    }
+
+    auto const period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>{1.0 / rateHz});
+    auto const start = std::chrono::steady_clock::now();
+    auto wake = start;
+    InputState state{};
+    while (true) {
+        double const elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (controller) {
+            controller->Periodic();
+            state = controller->GetRawState();
+        } else if (elapsed < testSeconds) {
+            script.Apply(units::second_t{elapsed}, state);
+        } else {
+            break;
+        }
+        sender.Send(controllerPort, state);
+
+        wake += period;
+        std::this_thread::sleep_until(wake);
+    }
+
+    printf("Sent %llu packets, dropped %llu and reordered %llu\n",
+            (unsigned long long)sender.sent, (unsigned long long)sender.dropped, (unsigned long long)sender.reordered);
+    close(fd);
+    return 0;
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "InputThread.hpp"
+#include <math.h>
+#include <stdint.h>
+
+/**
+ * The state of one input device for one robot loop, with
+ * axes normalized and shaped. It fits in a single cache line,
+ * so robot code reads input from plain memory.
+ */
+struct alignas(64) InputSnapshot {
+    static constexpr int kMaxAxes = InputState::kMaxAxes;
+    static constexpr int kMaxButtons = InputState::kMaxButtons;
+    static constexpr int kMaxHats = InputState::kMaxHats;
+
+    /** Axis values from -1.0 to 1.0, after deadband and expo */
+    float axes[kMaxAxes];
+    /** Bitmask of pressed buttons */
+    uint32_t buttons;
+    /** SDL_HAT_* values */
+    uint8_t hats[kMaxHats];
+    int8_t numAxes;
+    int8_t numButtons;
+    int8_t numHats;
+    /** Whether a device is connected; nothing else is valid if not */
+    bool connected;
+
+    /**
+     * Returns true if the given button is pressed.
+     */
+    bool GetButton(int button) const
+    {
+        return button >= 0 && button < kMaxButtons && ((buttons >> button) & 1);
+    }
+
+    /**
+     * Returns the value of the given axis from -1.0 to 1.0,
+     * or 0 if the axis does not exist.
+     */
+    double GetAxis(int axis) const
+    {
+        return axis >= 0 && axis < kMaxAxes ? axes[axis] : 0.0;
+    }
+
+    /**
+     * Returns the buttons that are pressed now but were not
+     * in the previous snapshot.
+     */
+    uint32_t Pressed(InputSnapshot const &previous) const
+    {
+        return buttons & ~previous.buttons;
+    }
+
+    /**
+     * Returns the buttons that were pressed in the previous
+     * snapshot but are not now.
+     */
+    uint32_t Released(InputSnapshot const &previous) const
+    {
+        return ~buttons & previous.buttons;
+    }
+};
+
+/**
+ * Converts raw device state into an InputSnapshot, applying
+ * a per-axis deadband and expo curve in the same branch-free
+ * pass that normalizes the axes, so the compiler can
+ * vectorize it across all axes at once.
+ */
+class InputShaper {
+private:
+    static constexpr int kMaxAxes = InputSnapshot::kMaxAxes;
+
+    /* kept as separate arrays so each step of the pass is one vector operation */
+    float _deadband[kMaxAxes]{};
+    float _scale[kMaxAxes] = {1, 1, 1, 1, 1, 1, 1, 1};
+    float _expo[kMaxAxes]{};
+    float _linear[kMaxAxes] = {1, 1, 1, 1, 1, 1, 1, 1};
+
+public:
+    /**
+     * Sets the shaping of the given axis. Values within the
+     * deadband read 0, and the rest of the range is rescaled
+     * so the output stays continuous. The expo blends from
+     * 0 (linear) to 1 (cubic), giving finer control near the
+     * center of the stick.
+     */
+    void SetAxis(int axis, double deadband, double expo)
+    {
+        if (axis < 0 || axis >= kMaxAxes) return;
+        if (deadband < 0) deadband = 0;
+        if (deadband > 0.99) deadband = 0.99;
+        if (expo < 0) expo = 0;
+        if (expo > 1) expo = 1;
+
+        _deadband[axis] = deadband;
+        _scale[axis] = 1.0 / (1.0 - deadband);
+        _expo[axis] = expo;
+        _linear[axis] = 1.0 - expo;
+    }
+
+    /**
+     * Fills the snapshot from the given raw state.
+     */
+    void Apply(InputState const &raw, InputSnapshot &snapshot) const
+    {
+        for (int i = 0; i < kMaxAxes; ++i) {
+            float const x = raw.axes[i] * (1.0f / 32768.0f);
+            float const magnitude = fmaxf(fabsf(x) - _deadband[i], 0.0f) * _scale[i];
+            float const shaped = magnitude * (_linear[i] + _expo[i] * magnitude * magnitude);
+            snapshot.axes[i] = copysignf(shaped, x);
+        }
+
+        snapshot.buttons = raw.buttons;
+        for (int i = 0; i < InputSnapshot::kMaxHats; ++i) {
+            snapshot.hats[i] = raw.hats[i];
+        }
+        snapshot.numAxes = raw.numAxes;
+        snapshot.numButtons = raw.numButtons;
+        snapshot.numHats = raw.numHats;
+        snapshot.connected = raw.connected;
+    }
+};
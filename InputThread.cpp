@@ -0,0 +1,347 @@
+#include "InputThread.hpp"
+#include <stdio.h>
+#include <string.h>
+
+namespace {
+
+/** Copies a device name into the state, which may be null. */
+void CopyName(InputState &state, char const *name)
+{
+    if (name) {
+        strncpy(state.name, name, InputState::kMaxNameLength - 1);
+    }
+}
+
+}
+
+/*static*/ std::mutex InputThread::s_instanceLck;
+/*static*/ std::weak_ptr<InputThread> InputThread::s_instance;
+
+/*static*/ std::shared_ptr<InputThread> InputThread::Acquire()
+{
+    std::lock_guard lck{s_instanceLck};
+
+    auto instance = s_instance.lock();
+    if (!instance) {
+        /* no devices are using the thread, start it up */
+        instance = std::shared_ptr<InputThread>{new InputThread{}};
+        s_instance = instance;
+    }
+    return instance;
+}
+
+InputThread::InputThread()
+{
+    /* wait for SDL to come up, so other threads can safely push events to the thread */
+    std::promise<bool> initialized;
+    auto result = initialized.get_future();
+    _thread = std::thread{[this, &initialized] {
+        bool const ok = InitSdl();
+        initialized.set_value(ok);
+        if (ok) {
+            Run();
+        }
+    }};
+    result.wait();
+}
+
+InputThread::~InputThread()
+{
+    _running = false;
+    Wake();
+    _thread.join();
+}
+
+SeqLock<InputState> const &InputThread::Subscribe(int port, DeviceKind kind)
+{
+    if (port < 0 || port >= kMaxPorts) {
+        fprintf(stderr, "Error: Input port %d is out of range [0, %d)\n", port, kMaxPorts);
+        return _disconnected;
+    }
+
+    /* let the thread open a device for the new subscription */
+    Slot &slot = _slots[(int)kind][port];
+    if (!slot.subscribed.exchange(true)) {
+        Wake();
+    }
+    return slot.state;
+}
+
+bool InputThread::InitSdl()
+{
+    SDL_SetHint(SDL_HINT_NO_SIGNAL_HANDLERS, "1"); // so Ctrl-C still works
+    if (SDL_Init(SDL_INIT_GAMECONTROLLER) < 0) {
+        fprintf(stderr, "Error initializing SDL: %s\n", SDL_GetError());
+        return false;
+    }
+
+    _wakeEvent = SDL_RegisterEvents(1);
+    return true;
+}
+
+void InputThread::Wake()
+{
+    if (_wakeEvent == (Uint32)-1) {
+        /* SDL is not running */
+        return;
+    }
+
+    SDL_Event event{};
+    event.type = _wakeEvent;
+    SDL_PushEvent(&event);
+}
+
+void InputThread::Run()
+{
+    /* open whatever is already plugged in */
+    OpenMissing();
+    PublishStates();
+
+    while (_running) {
+        SDL_Event event;
+        if (!SDL_WaitEvent(&event)) {
+            fprintf(stderr, "Error waiting for input events: %s\n", SDL_GetError());
+            break;
+        }
+
+        /* drain the whole event queue before publishing */
+        bool added = false;
+        do {
+            if (event.type == SDL_JOYDEVICEADDED) {
+                added = true;
+            }
+            else if (event.type == SDL_JOYDEVICEREMOVED) {
+                /* only close the device that was actually removed */
+                CloseInstance(event.jdevice.which);
+            }
+            else if (event.type == _wakeEvent) {
+                /* a new subscription may be waiting for a device */
+                added = true;
+            }
+        } while (SDL_PollEvent(&event));
+
+        if (added) {
+            OpenMissing();
+        }
+        PublishStates();
+    }
+
+    /* program shutting down */
+    CloseDevices();
+    PublishStates();
+    SDL_Quit();
+}
+
+void InputThread::OpenMissing()
+{
+    int const numDevices = SDL_NumJoysticks();
+    if (numDevices < 0) {
+        /* error trying to get joysticks */
+        fprintf(stderr, "Error getting joysticks: %s\n", SDL_GetError());
+        return;
+    }
+
+    for (int kind = 0; kind < kNumDeviceKinds; ++kind) {
+        /* assign unclaimed devices to the missing ports in order */
+        int deviceIndex = 0;
+        for (int port = 0; port < kMaxPorts; ++port) {
+            Slot &slot = _slots[kind][port];
+            if (!slot.subscribed || slot.joy) continue;
+
+            while (deviceIndex < numDevices && !OpenDevice(slot, deviceIndex, (DeviceKind)kind)) {
+                ++deviceIndex;
+            }
+
+            if (slot.joy) {
+                /* print information about the device */
+                slot.reportedMissing = false;
+                PrintDeviceInfo(slot, port);
+            } else {
+                ReportMissingDevice(slot, port, (DeviceKind)kind);
+            }
+        }
+    }
+}
+
+bool InputThread::IsClaimed(int deviceIndex, DeviceKind kind) const
+{
+    SDL_JoystickID const instanceId = SDL_JoystickGetDeviceInstanceID(deviceIndex);
+    for (auto const &slot : _slots[(int)kind]) {
+        if (slot.joy && slot.instanceId == instanceId) return true;
+    }
+    return false;
+}
+
+bool InputThread::OpenDevice(Slot &slot, int deviceIndex, DeviceKind kind)
+{
+    if (IsClaimed(deviceIndex, kind)) {
+        /* already in use by another port */
+        return false;
+    }
+
+    if (kind == DeviceKind::GameController) {
+        if (!SDL_IsGameController(deviceIndex)) {
+            /* not a valid game controller */
+            return false;
+        }
+        slot.controller = SDL_GameControllerOpen(deviceIndex);
+        if (slot.controller) {
+            slot.joy = SDL_GameControllerGetJoystick(slot.controller);
+        }
+    } else {
+        slot.joy = SDL_JoystickOpen(deviceIndex);
+    }
+
+    if (!slot.joy) {
+        CloseDevice(slot);
+        return false;
+    }
+    slot.instanceId = SDL_JoystickInstanceID(slot.joy);
+    return true;
+}
+
+/*static*/ void InputThread::CloseDevice(Slot &slot)
+{
+    if (slot.controller) {
+        /* this also closes the underlying joystick */
+        SDL_GameControllerClose(slot.controller);
+    } else if (slot.joy) {
+        SDL_JoystickClose(slot.joy);
+    }
+    slot.controller = nullptr;
+    slot.joy = nullptr;
+    slot.instanceId = -1;
+}
+
+void InputThread::CloseInstance(SDL_JoystickID instanceId)
+{
+    for (int kind = 0; kind < kNumDeviceKinds; ++kind) {
+        for (int port = 0; port < kMaxPorts; ++port) {
+            Slot &slot = _slots[kind][port];
+            if (slot.joy && slot.instanceId == instanceId) {
+                CloseDevice(slot);
+                ReportMissingDevice(slot, port, (DeviceKind)kind);
+            }
+        }
+    }
+}
+
+void InputThread::CloseDevices()
+{
+    for (auto &slots : _slots) {
+        for (auto &slot : slots) {
+            CloseDevice(slot);
+        }
+    }
+}
+
+void InputThread::PublishStates()
+{
+    for (auto &slots : _slots) {
+        for (auto &slot : slots) {
+            if (!slot.subscribed) continue;
+
+            InputState state{};
+            ReadState(slot, state);
+            slot.state.Store(state);
+        }
+    }
+}
+
+/*static*/ void InputThread::ReadState(Slot const &slot, InputState &state)
+{
+    state = InputState{};
+    if (!slot.joy) {
+        /* no device */
+        return;
+    }
+    state.connected = true;
+
+    if (slot.controller) {
+        /* game controllers report their mapped axes and buttons */
+#if SDL_VERSION_ATLEAST(2, 0, 12)
+        state.type = SDL_GameControllerGetType(slot.controller);
+#else
+        /* SDL reports controller types from 2.0.12 on; this is SDL_CONTROLLER_TYPE_UNKNOWN */
+        state.type = 0;
+#endif
+        state.numAxes = SDL_CONTROLLER_AXIS_MAX;
+        state.numButtons = SDL_CONTROLLER_BUTTON_MAX < InputState::kMaxButtons ? SDL_CONTROLLER_BUTTON_MAX : InputState::kMaxButtons;
+        state.numHats = 0;
+        for (int i = 0; i < state.numAxes; ++i) {
+            state.axes[i] = SDL_GameControllerGetAxis(slot.controller, (SDL_GameControllerAxis)i);
+        }
+        for (int i = 0; i < state.numButtons; ++i) {
+            if (SDL_GameControllerGetButton(slot.controller, (SDL_GameControllerButton)i)) {
+                state.buttons |= 1u << i;
+            }
+        }
+        CopyName(state, SDL_GameControllerName(slot.controller));
+        return;
+    }
+
+    state.type = SDL_JoystickGetType(slot.joy);
+    state.numAxes = SDL_JoystickNumAxes(slot.joy);
+    state.numButtons = SDL_JoystickNumButtons(slot.joy);
+    state.numHats = SDL_JoystickNumHats(slot.joy);
+    for (int i = 0; i < state.numAxes && i < InputState::kMaxAxes; ++i) {
+        state.axes[i] = SDL_JoystickGetAxis(slot.joy, i);
+    }
+    for (int i = 0; i < state.numButtons && i < InputState::kMaxButtons; ++i) {
+        if (SDL_JoystickGetButton(slot.joy, i)) {
+            state.buttons |= 1u << i;
+        }
+    }
+    for (int i = 0; i < state.numHats && i < InputState::kMaxHats; ++i) {
+        state.hats[i] = SDL_JoystickGetHat(slot.joy, i);
+    }
+    CopyName(state, SDL_JoystickName(slot.joy));
+}
+
+/*static*/ void InputThread::ReportMissingDevice(Slot &slot, int port, DeviceKind kind)
+{
+    if (!slot.reportedMissing) {
+        fprintf(stderr, "Warning: Could not find %s on port %d, waiting for one to be plugged in\n",
+                kind == DeviceKind::GameController ? "game controller" : "joystick", port);
+        slot.reportedMissing = true;
+    }
+}
+
+/*static*/ void InputThread::PrintDeviceInfo(Slot const &slot, int port)
+{
+    InputState state{};
+    ReadState(slot, state);
+
+    if (slot.controller) {
+        char const *typeStr = "Unknown";
+#if SDL_VERSION_ATLEAST(2, 0, 12)
+        switch (state.type) {
+            case SDL_CONTROLLER_TYPE_XBOX360: typeStr = "Xbox 360"; break;
+            case SDL_CONTROLLER_TYPE_XBOXONE: typeStr = "Xbox One"; break;
+            case SDL_CONTROLLER_TYPE_PS3: typeStr = "PS3"; break;
+            case SDL_CONTROLLER_TYPE_PS4: typeStr = "PS4"; break;
+#if SDL_VERSION_ATLEAST(2, 0, 14)
+            case SDL_CONTROLLER_TYPE_PS5: typeStr = "PS5"; break;
+#endif
+
+            default:
+            case SDL_CONTROLLER_TYPE_UNKNOWN: typeStr = "Unknown"; break;
+        }
+#endif
+
+        /* print information */
+        printf("Connected to game controller '%s'\n"
+                "    Type: %s\n"
+                "    Port: %d\n",
+                state.name, typeStr, port);
+    } else {
+        /* print information */
+        printf("Connected to joystick '%s'\n"
+                "    Port: %d\n"
+                "    Num Axes: %d\n"
+                "    Num Buttons: %d\n"
+                "    Num Hats: %d\n",
+                state.name, port,
+                state.numAxes, state.numButtons, state.numHats);
+    }
+}
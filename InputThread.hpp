@@ -0,0 +1,136 @@
+#pragma once
+
+#include "SeqLock.hpp"
+#include <SDL2/SDL.h>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <stdint.h>
+
+/**
+ * A complete snapshot of the state of one input device.
+ */
+struct InputState {
+    static constexpr int kMaxAxes = 8;
+    static constexpr int kMaxButtons = 32;
+    static constexpr int kMaxHats = 4;
+    static constexpr int kMaxNameLength = 64;
+
+    /** Whether a device is connected; nothing else is valid if not */
+    bool connected;
+    /** SDL_JoystickType or SDL_GameControllerType of the device */
+    int type;
+    int numAxes;
+    int numButtons;
+    int numHats;
+    /** Raw axis values from -32768 to 32767 */
+    int16_t axes[kMaxAxes];
+    /** Bitmask of pressed buttons */
+    uint32_t buttons;
+    /** SDL_HAT_* values */
+    uint8_t hats[kMaxHats];
+    char name[kMaxNameLength];
+};
+
+/**
+ * Owns the SDL 2 library and runs all input handling on its
+ * own thread. The thread blocks waiting for SDL events,
+ * drains the whole event queue, and then publishes a
+ * complete state snapshot of every device, so the robot loop
+ * reads input without ever calling into SDL.
+ *
+ * SDL is initialized exactly once, when the thread starts.
+ * Devices are opened and closed in response to SDL hotplug
+ * events and tracked by their instance ID, so a missing
+ * device costs nothing until one is plugged in. A newly
+ * added device is assigned to the lowest missing port.
+ *
+ * The thread starts with the first device and stops, quitting
+ * SDL, once the last device releases it.
+ */
+class InputThread {
+public:
+    /**
+     * The SDL API used to open a device.
+     */
+    enum class DeviceKind {
+        Joystick,
+        GameController,
+    };
+    static constexpr int kNumDeviceKinds = 2;
+    static constexpr int kMaxPorts = 8;
+
+    /**
+     * Returns the input thread, starting it if needed.
+     * The thread runs while any returned pointer is alive.
+     */
+    static std::shared_ptr<InputThread> Acquire();
+
+    ~InputThread();
+
+    InputThread(InputThread const &) = delete;
+    InputThread &operator=(InputThread const &) = delete;
+
+    /**
+     * Asks the thread to open the device on the given port,
+     * returning the snapshot the thread publishes its state to.
+     */
+    SeqLock<InputState> const &Subscribe(int port, DeviceKind kind);
+
+private:
+    InputThread();
+
+    struct Slot {
+        std::atomic<bool> subscribed{false};
+        SeqLock<InputState> state{};
+
+        /* owned by the input thread */
+        SDL_Joystick *joy = nullptr;
+        SDL_GameController *controller = nullptr;
+        SDL_JoystickID instanceId = -1;
+        bool reportedMissing = false;
+    };
+
+    static std::mutex s_instanceLck;
+    static std::weak_ptr<InputThread> s_instance;
+
+    std::array<std::array<Slot, kMaxPorts>, kNumDeviceKinds> _slots{};
+    /* published for invalid ports, and never connected */
+    SeqLock<InputState> _disconnected{};
+
+    std::atomic<bool> _running{true};
+    std::thread _thread;
+    /* SDL user event used to wake up the thread */
+    Uint32 _wakeEvent = (Uint32)-1;
+
+    /** Initializes SDL; runs on the input thread. */
+    bool InitSdl();
+    /** Runs the input thread. */
+    void Run();
+    /** Wakes up the input thread. */
+    void Wake();
+    /** Opens devices for any subscribed ports that are missing one. */
+    void OpenMissing();
+    /** Closes the device with the given instance ID. */
+    void CloseInstance(SDL_JoystickID instanceId);
+    /** Closes every device. */
+    void CloseDevices();
+    /** Publishes the current state of every subscribed device. */
+    void PublishStates();
+    /** Returns whether the device at the given index is already open in a slot of the given kind. */
+    bool IsClaimed(int deviceIndex, DeviceKind kind) const;
+
+    /** Opens the device at the given index in the given slot. */
+    bool OpenDevice(Slot &slot, int deviceIndex, DeviceKind kind);
+    /** Closes the device in the given slot. */
+    static void CloseDevice(Slot &slot);
+    /** Reads the current state of the device in the given slot. */
+    static void ReadState(Slot const &slot, InputState &state);
+    /** Reports a missing device once until it is found. */
+    static void ReportMissingDevice(Slot &slot, int port, DeviceKind kind);
+    /** Prints out information about a newly opened device. */
+    static void PrintDeviceInfo(Slot const &slot, int port);
+};
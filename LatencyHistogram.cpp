@@ -0,0 +1,69 @@
+#include "LatencyHistogram.hpp"
+
+/*static*/ uint64_t LatencyHistogram::BucketUpperBound(size_t index)
+{
+    if (index < kSubBuckets) {
+        return index;
+    }
+    int const shift = (index - kSubBuckets) / kSubBuckets;
+    uint64_t const sub = (index - kSubBuckets) % kSubBuckets;
+    return ((kSubBuckets + sub) << shift) + ((1ULL << shift) - 1);
+}
+
+LatencyHistogram::Summary LatencyHistogram::GetSummary() const
+{
+    /* take one pass over the buckets, so the percentiles are consistent with each other */
+    std::array<uint64_t, kNumBuckets> buckets;
+    uint64_t count = 0;
+    size_t first = kNumBuckets;
+    size_t last = 0;
+    for (size_t i = 0; i < kNumBuckets; ++i) {
+        buckets[i] = _buckets[i].load(std::memory_order_relaxed);
+        count += buckets[i];
+        if (buckets[i] != 0) {
+            if (first == kNumBuckets) first = i;
+            last = i;
+        }
+    }
+
+    Summary summary{};
+    summary.count = count;
+    if (count == 0) {
+        return summary;
+    }
+
+    auto const toUs = [](uint64_t ns) { return units::microsecond_t{ns / 1000.0}; };
+
+    /* Record() stores the bucket first, so the other fields may not include the latest sample yet;
+     * keep the extremes within the buckets seen, and average over the bucket count */
+    uint64_t const lowest = BucketUpperBound(first);
+    uint64_t const highest = last > 0 ? BucketUpperBound(last - 1) + 1 : 0;
+    uint64_t min = _min.load(std::memory_order_relaxed);
+    uint64_t max = _max.load(std::memory_order_relaxed);
+    if (min > lowest) min = lowest;
+    if (max < highest) max = highest;
+    summary.min = toUs(min);
+    summary.max = toUs(max);
+    summary.mean = toUs(_sum.load(std::memory_order_relaxed) / count);
+
+    /* the percentile targets, rounded up to whole samples */
+    uint64_t const targets[] = {
+        (count * 500 + 999) / 1000,
+        (count * 990 + 999) / 1000,
+        (count * 999 + 999) / 1000,
+    };
+    units::microsecond_t *const results[] = {&summary.p50, &summary.p99, &summary.p999};
+
+    size_t target = 0;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kNumBuckets && target < 3; ++i) {
+        seen += buckets[i];
+        while (target < 3 && seen >= targets[target]) {
+            /* never report past the largest recorded value */
+            uint64_t const bound = BucketUpperBound(i);
+            *results[target] = toUs(bound < max ? bound : max);
+            ++target;
+        }
+    }
+    return summary;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "SingleWriter.hpp"
+#include "units/time.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <stdint.h>
+
+/**
+ * Log-linear histogram of durations, written by one thread
+ * and readable from any other thread at any time.
+ *
+ * Each power of two is split into 32 linear sub-buckets, so
+ * every reported percentile is within about 3% of the true
+ * value across the whole range of 1 ns to 18 minutes.
+ * Recording is a handful of relaxed atomic stores with no
+ * locks and no allocations.
+ */
+class LatencyHistogram {
+public:
+    /**
+     * Summary of the recorded durations.
+     */
+    struct Summary {
+        uint64_t count;
+        units::microsecond_t min;
+        units::microsecond_t mean;
+        units::microsecond_t p50;
+        units::microsecond_t p99;
+        units::microsecond_t p999;
+        units::microsecond_t max;
+    };
+
+    /**
+     * Records a duration. Only one thread may record into a
+     * given histogram.
+     */
+    void Record(std::chrono::nanoseconds duration)
+    {
+        uint64_t const ns = duration.count() > 0 ? duration.count() : 0;
+        SingleWriterAdd(_buckets[BucketIndex(ns)]);
+        SingleWriterAdd(_sum, ns);
+        if (ns < _min.load(std::memory_order_relaxed)) {
+            _min.store(ns, std::memory_order_relaxed);
+        }
+        if (ns > _max.load(std::memory_order_relaxed)) {
+            _max.store(ns, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * Returns a summary of the recorded durations. This may be
+     * called from any thread, concurrently with Record().
+     */
+    Summary GetSummary() const;
+
+private:
+    static constexpr int kSubBucketBits = 5;
+    static constexpr uint64_t kSubBuckets = 1 << kSubBucketBits;
+    static constexpr int kMaxValueBits = 40;
+    static constexpr size_t kNumBuckets = kSubBuckets + (kMaxValueBits - kSubBucketBits) * kSubBuckets;
+
+    std::array<std::atomic<uint64_t>, kNumBuckets> _buckets{};
+    std::atomic<uint64_t> _sum{0};
+    std::atomic<uint64_t> _min{UINT64_MAX};
+    std::atomic<uint64_t> _max{0};
+
+    static size_t BucketIndex(uint64_t ns)
+    {
+        if (ns < kSubBuckets) {
+            /* small values are recorded exactly */
+            return ns;
+        }
+        if (ns >= (1ULL << kMaxValueBits)) {
+            return kNumBuckets - 1;
+        }
+        /* the bits below the most significant bit select the sub-bucket within its power of two */
+        int const shift = (63 - __builtin_clzll(ns)) - kSubBucketBits;
+        return kSubBuckets + shift * kSubBuckets + ((ns >> shift) - kSubBuckets);
+    }
+
+    /** Returns the largest value recorded into the given bucket. */
+    static uint64_t BucketUpperBound(size_t index);
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "units/time.h"
+#include <chrono>
+
+/**
+ * The time source that schedules the robot loop. The default
+ * is the monotonic clock; a SimulatedClock runs the loop
+ * faster than real time.
+ */
+class LoopClock {
+public:
+    using time_point = std::chrono::steady_clock::time_point;
+
+    virtual ~LoopClock() = default;
+
+    /**
+     * Returns the current time.
+     */
+    virtual time_point Now() = 0;
+
+    /**
+     * Waits until the given time, busy-waiting for the final
+     * spin time where that applies.
+     */
+    virtual void SleepUntil(time_point deadline, units::microsecond_t spin) = 0;
+};
+
+/**
+ * A clock that only moves when waited on, so the robot loop
+ * never sleeps and every cycle takes no simulated time. The
+ * loop's periodic callbacks are scheduled on it as well.
+ */
+class SimulatedClock final : public LoopClock {
+private:
+    time_point _now{};
+
+public:
+    time_point Now() override { return _now; }
+
+    void SleepUntil(time_point deadline, units::microsecond_t /*spin*/) override
+    {
+        if (deadline > _now) _now = deadline;
+    }
+};
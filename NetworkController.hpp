@@ -0,0 +1,9 @@
+#pragma once
+
+#include "InputDevice.hpp"
+
+/**
+ * A controller at a remote operator station, received over
+ * UDP from InputSender.
+ */
+using NetworkController = InputDevice<NetworkBackend>;
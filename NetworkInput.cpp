@@ -0,0 +1,171 @@
+#include "NetworkInput.hpp"
+#include "SingleWriter.hpp"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+/*static*/ std::mutex NetworkInput::s_instanceLck;
+/*static*/ std::weak_ptr<NetworkInput> NetworkInput::s_instance;
+/*static*/ NetworkInput::Settings NetworkInput::s_settings{};
+
+/*static*/ void NetworkInput::Configure(Settings settings)
+{
+    std::lock_guard lck{s_instanceLck};
+    if (!s_instance.expired()) {
+        fprintf(stderr, "Warning: Network input is already running, its settings will apply after it restarts\n");
+    }
+    s_settings = settings;
+}
+
+/*static*/ std::shared_ptr<NetworkInput> NetworkInput::Acquire()
+{
+    std::lock_guard lck{s_instanceLck};
+
+    auto instance = s_instance.lock();
+    if (!instance) {
+        /* no devices are using the receiver, start it up */
+        instance = std::shared_ptr<NetworkInput>{new NetworkInput{s_settings}};
+        s_instance = instance;
+    }
+    return instance;
+}
+
+NetworkInput::NetworkInput(Settings settings) :
+    _timeoutNs{(int64_t)(settings.timeout.value() * 1e6)},
+    _maxAgeNs{(int64_t)(settings.maxAge.value() * 1e6)}
+{
+    /* if the socket cannot be set up, every port stays disconnected, so the robot stays disabled */
+    _socket = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (_socket < 0) {
+        fprintf(stderr, "Error: Could not create the network input socket: %s\n", strerror(errno));
+        return;
+    }
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(settings.udpPort);
+    if (bind(_socket, (sockaddr *)&address, sizeof(address)) != 0) {
+        fprintf(stderr, "Error: Could not receive network input on UDP port %u: %s\n", settings.udpPort, strerror(errno));
+        close(_socket);
+        _socket = -1;
+        return;
+    }
+
+    /* wake up regularly to notice when we are stopped */
+    timeval timeout{0, 100000};
+    setsockopt(_socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    printf("Receiving network input on UDP port %u\n", settings.udpPort);
+    _thread = std::thread{&NetworkInput::Run, this};
+}
+
+NetworkInput::~NetworkInput()
+{
+    _running = false;
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+    if (_socket >= 0) {
+        close(_socket);
+    }
+}
+
+NetworkInput::Stats NetworkInput::GetStats() const
+{
+    return Stats{
+        _received.load(std::memory_order_relaxed),
+        _accepted.load(std::memory_order_relaxed),
+        _reordered.load(std::memory_order_relaxed),
+        _stale.load(std::memory_order_relaxed),
+        _lost.load(std::memory_order_relaxed),
+        _malformed.load(std::memory_order_relaxed),
+        _latency.GetSummary(),
+    };
+}
+
+void NetworkInput::Run()
+{
+    /* one byte more than a packet, so an oversized datagram is not truncated into a valid one */
+    alignas(Packet) uint8_t buffer[sizeof(Packet) + 1];
+
+    while (_running.load(std::memory_order_relaxed)) {
+        sockaddr_in sender{};
+        socklen_t senderLength = sizeof(sender);
+        ssize_t const size = recvfrom(_socket, buffer, sizeof(buffer), 0, (sockaddr *)&sender, &senderLength);
+        if (size < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                fprintf(stderr, "Error: Could not receive network input: %s\n", strerror(errno));
+                std::this_thread::sleep_for(std::chrono::milliseconds{100});
+            }
+            continue;
+        }
+
+        char senderName[INET_ADDRSTRLEN] = "";
+        inet_ntop(AF_INET, &sender.sin_addr, senderName, sizeof(senderName));
+        Receive(*reinterpret_cast<Packet const *>(buffer), size, senderName);
+    }
+}
+
+void NetworkInput::Receive(Packet const &packet, size_t size, char const *sender)
+{
+    timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    int64_t const receiveTimeNs = (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+
+    SingleWriterAdd(_received);
+    if (size != sizeof(Packet) || packet.magic != kMagic || packet.version != kVersion || packet.port >= kMaxPorts) {
+        SingleWriterAdd(_malformed);
+        return;
+    }
+
+    Slot &slot = _slots[packet.port];
+    if (slot.active && packet.session == slot.session) {
+        /* compare with wraparound, so the sequence can run forever */
+        int32_t const delta = (int32_t)(packet.sequence - slot.sequence);
+        if (delta <= 0) {
+            SingleWriterAdd(_reordered);
+            return;
+        }
+        SingleWriterAdd(_lost, delta - 1);
+    } else if (slot.active) {
+        /* a late packet from before the sender restarted must not replace the new session,
+         * so only switch sessions to a newer packet, or once the current one has timed out */
+        int64_t const age = std::chrono::steady_clock::now().time_since_epoch().count() -
+            slot.receiveTimeNs.load(std::memory_order_relaxed);
+        if (packet.sendTimeNs <= slot.sendTimeNs && age <= _timeoutNs) {
+            SingleWriterAdd(_reordered);
+            return;
+        }
+    }
+    slot.active = true;
+    slot.session = packet.session;
+    slot.sequence = packet.sequence;
+    slot.sendTimeNs = packet.sendTimeNs;
+
+    int64_t const latencyNs = receiveTimeNs - packet.sendTimeNs;
+    _latency.Record(std::chrono::nanoseconds{latencyNs});
+    if (_maxAgeNs > 0 && latencyNs > _maxAgeNs) {
+        SingleWriterAdd(_stale);
+        return;
+    }
+
+    InputState state{};
+    state.connected = packet.connected != 0;
+    state.numAxes = packet.numAxes < InputState::kMaxAxes ? packet.numAxes : InputState::kMaxAxes;
+    state.numButtons = packet.numButtons < InputState::kMaxButtons ? packet.numButtons : InputState::kMaxButtons;
+    state.numHats = packet.numHats < InputState::kMaxHats ? packet.numHats : InputState::kMaxHats;
+    memcpy(state.axes, packet.axes, sizeof(state.axes));
+    state.buttons = packet.buttons;
+    memcpy(state.hats, packet.hats, sizeof(state.hats));
+    snprintf(state.name, sizeof(state.name), "Network controller at %s", sender);
+
+    slot.state.Store(state);
+    slot.receiveTimeNs.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+    SingleWriterAdd(_accepted);
+}
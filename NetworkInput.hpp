@@ -0,0 +1,189 @@
+#pragma once
+
+#include "InputThread.hpp"
+#include "LatencyHistogram.hpp"
+#include "SeqLock.hpp"
+#include "units/time.h"
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <stdint.h>
+
+/**
+ * Receives controller states from a remote operator station as
+ * UDP datagrams, on its own thread, so the robot loop reads
+ * network input from a snapshot without ever calling into the
+ * socket. InputSender sends them.
+ *
+ * Each datagram is one Packet carrying the complete state of one
+ * controller port, so a lost packet is made up for by the next.
+ * Packets are sequenced within a session of the sender, and any
+ * packet that is not newer than the last accepted one for its
+ * port is dropped, so the state never goes back in time. A new
+ * session takes over only with a packet sent after the latest
+ * one of the current session, or once that has timed out. A port
+ * reads as disconnected once no packet has arrived for the
+ * timeout, which disables a robot that requires a connected
+ * controller to enable.
+ *
+ * The thread starts with the first device and stops, closing
+ * the socket, once the last device releases it.
+ */
+class NetworkInput {
+public:
+    static constexpr uint16_t kDefaultUdpPort = 5810;
+    static constexpr int kMaxPorts = InputThread::kMaxPorts;
+
+    static constexpr uint32_t kMagic = 0x494E3650; // "P6NI" in little-endian
+    static constexpr uint16_t kVersion = 1;
+
+    /**
+     * One controller state datagram, in the byte order of the
+     * sender, which must match the robot's.
+     */
+    struct Packet {
+        uint32_t magic;
+        uint16_t version;
+        /** The controller port on the robot */
+        uint8_t port;
+        /** Whether a controller is connected at the operator station */
+        uint8_t connected;
+        /** Picked at random when the sender starts, so a restarted sender is not dropped as stale */
+        uint32_t session;
+        /** Increments with every packet of the session and port */
+        uint32_t sequence;
+        /** When the state was read, in nanoseconds of CLOCK_REALTIME */
+        int64_t sendTimeNs;
+        /** Raw axis values from -32768 to 32767 */
+        int16_t axes[InputState::kMaxAxes];
+        /** Bitmask of pressed buttons */
+        uint32_t buttons;
+        /** SDL_HAT_* values */
+        uint8_t hats[InputState::kMaxHats];
+        uint8_t numAxes;
+        uint8_t numButtons;
+        uint8_t numHats;
+        uint8_t reserved;
+    };
+    static_assert(sizeof(Packet) == 56, "the packet layout is part of the protocol");
+
+    struct Settings {
+        /** The UDP port to receive on */
+        uint16_t udpPort = kDefaultUdpPort;
+        /** How long after its last packet a port reads as disconnected */
+        units::millisecond_t timeout = 100_ms;
+        /**
+         * Packets older than this are dropped as stale, or 0 to
+         * accept packets of any age. This compares the clocks of
+         * both computers, so they must be synchronized, such as
+         * with NTP or PTP.
+         */
+        units::millisecond_t maxAge = 0_ms;
+    };
+
+    /**
+     * Statistics of the received packets.
+     */
+    struct Stats {
+        /** Datagrams received, valid or not */
+        uint64_t received;
+        /** Packets that updated the state of a port */
+        uint64_t accepted;
+        /** Packets dropped for arriving after a newer one, or twice */
+        uint64_t reordered;
+        /** Packets dropped for being older than Settings::maxAge */
+        uint64_t stale;
+        /** Packets skipped over in the sequence, including any that arrive later as reordered */
+        uint64_t lost;
+        /** Datagrams that were not a valid packet */
+        uint64_t malformed;
+        /** Time from reading the state at the sender to receiving it */
+        LatencyHistogram::Summary latency;
+    };
+
+    /**
+     * Sets how the receiver runs. This must be called before
+     * the first network device is created.
+     */
+    static void Configure(Settings settings);
+
+    /**
+     * Returns the receiver, starting it if needed.
+     * The thread runs while any returned pointer is alive.
+     */
+    static std::shared_ptr<NetworkInput> Acquire();
+
+    ~NetworkInput();
+
+    NetworkInput(NetworkInput const &) = delete;
+    NetworkInput &operator=(NetworkInput const &) = delete;
+
+    /**
+     * Copies out the latest state of the given port, which
+     * reads as disconnected if its packets have stopped.
+     */
+    void Read(int port, InputState &state) const
+    {
+        if (port < 0 || port >= kMaxPorts) {
+            state = InputState{};
+            return;
+        }
+        Slot const &slot = _slots[port];
+        slot.state.Load(state);
+
+        int64_t const age = std::chrono::steady_clock::now().time_since_epoch().count() -
+            slot.receiveTimeNs.load(std::memory_order_relaxed);
+        if (age > _timeoutNs) {
+            state.connected = false;
+        }
+    }
+
+    /**
+     * Returns the statistics of the received packets.
+     * This may be called from any thread.
+     */
+    Stats GetStats() const;
+
+private:
+    explicit NetworkInput(Settings settings);
+
+    struct Slot {
+        SeqLock<InputState> state{};
+        /* steady clock time of the last accepted packet */
+        std::atomic<int64_t> receiveTimeNs{INT64_MIN / 2};
+
+        /* owned by the receive thread */
+        bool active = false;
+        uint32_t session = 0;
+        uint32_t sequence = 0;
+        /* sender's time of the latest packet of the session */
+        int64_t sendTimeNs = 0;
+    };
+
+    static std::mutex s_instanceLck;
+    static std::weak_ptr<NetworkInput> s_instance;
+    static Settings s_settings;
+
+    std::array<Slot, kMaxPorts> _slots{};
+    int64_t const _timeoutNs;
+    int64_t const _maxAgeNs;
+
+    int _socket = -1;
+    std::atomic<bool> _running{true};
+    std::thread _thread;
+
+    std::atomic<uint64_t> _received{0};
+    std::atomic<uint64_t> _accepted{0};
+    std::atomic<uint64_t> _reordered{0};
+    std::atomic<uint64_t> _stale{0};
+    std::atomic<uint64_t> _lost{0};
+    std::atomic<uint64_t> _malformed{0};
+    LatencyHistogram _latency{};
+
+    /** Runs the receive thread. */
+    void Run();
+    /** Applies one received datagram. */
+    void Receive(Packet const &packet, size_t size, char const *sender);
+};
@@ -0,0 +1,165 @@
+#include "Odometry.hpp"
+#include "SingleWriter.hpp"
+#include "ctre/phoenix6/Utils.hpp"
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+
+using namespace ctre::phoenix6;
+
+Odometry::Odometry(hardware::TalonFX &left, hardware::TalonFX &right, Constants constants, units::hertz_t frequency) :
+    _leftPosition{left.GetPosition()},
+    _leftVelocity{left.GetVelocity()},
+    _rightPosition{right.GetPosition()},
+    _rightVelocity{right.GetVelocity()},
+    _constants{constants},
+    _frequency{frequency}
+{}
+
+void Odometry::Start()
+{
+    if (_thread.joinable()) return;
+
+    auto const status = BaseStatusSignal::SetUpdateFrequencyForAll(_frequency,
+            _leftPosition, _leftVelocity, _rightPosition, _rightVelocity);
+    if (!status.IsOK()) {
+        fprintf(stderr, "Warning: Could not set the odometry signal frequency: %s\n", status.GetName());
+    }
+
+    _running = true;
+    _thread = std::thread{[this] { Run(); }};
+}
+
+void Odometry::Stop()
+{
+    if (_thread.joinable()) {
+        _running = false;
+        _thread.join();
+    }
+}
+
+void Odometry::ResetPose(double xMeters, double yMeters, double headingRadians)
+{
+    Sample pose{};
+    pose.xMeters = xMeters;
+    pose.yMeters = yMeters;
+    pose.headingRadians = headingRadians;
+    _reset.Store(pose);
+}
+
+void Odometry::Run()
+{
+    /* wait up to two periods, so a single late frame is not a timeout */
+    units::second_t const timeout{2.0 / _frequency.value()};
+    std::chrono::nanoseconds const timeoutNs{(int64_t)(timeout.value() * 1e9)};
+    double const metersPerTurn = 2 * M_PI * _constants.wheelRadiusMeters / _constants.gearRatio;
+
+    Sample pose{};
+    uint32_t resetVersion = _reset.GetVersion();
+    bool first = true;
+    double lastLeft = 0;
+    double lastRight = 0;
+
+    while (_running) {
+        auto const waitStart = std::chrono::steady_clock::now();
+        auto const status = BaseStatusSignal::WaitForAll(timeout, _leftPosition, _leftVelocity, _rightPosition, _rightVelocity);
+        if (!status.IsOK()) {
+            SingleWriterAdd(_timeouts);
+            /* the wait can also fail early (such as for a missing device), so wait out the timeout */
+            std::this_thread::sleep_until(waitStart + timeoutNs);
+            continue;
+        }
+
+        /* extrapolate the positions to now with the velocities, and stamp them with that time */
+        double const left = BaseStatusSignal::GetLatencyCompensatedValue(_leftPosition, _leftVelocity).value() * metersPerTurn;
+        double const right = BaseStatusSignal::GetLatencyCompensatedValue(_rightPosition, _rightVelocity).value() * metersPerTurn;
+        double const timestamp = utils::GetCurrentTimeSeconds().value();
+
+        uint32_t const version = _reset.GetVersion();
+        if (version != resetVersion) {
+            Sample const reset = _reset.Load();
+            pose.xMeters = reset.xMeters;
+            pose.yMeters = reset.yMeters;
+            pose.headingRadians = reset.headingRadians;
+            resetVersion = version;
+        } else if (!first) {
+            /* integrate along the arc, using the heading halfway through the step */
+            double const dLeft = left - lastLeft;
+            double const dRight = right - lastRight;
+            double const distance = (dLeft + dRight) / 2;
+            double const dHeading = (dRight - dLeft) / _constants.trackWidthMeters;
+            double const heading = pose.headingRadians + dHeading / 2;
+
+            pose.xMeters += distance * cos(heading);
+            pose.yMeters += distance * sin(heading);
+            pose.headingRadians += dHeading;
+
+            _period.Record(std::chrono::nanoseconds{(int64_t)((timestamp - pose.timestamp) * 1e9)});
+        }
+        first = false;
+        lastLeft = left;
+        lastRight = right;
+
+        pose.timestamp = timestamp;
+        pose.leftSpeed = _leftVelocity.GetValue().value() * metersPerTurn;
+        pose.rightSpeed = _rightVelocity.GetValue().value() * metersPerTurn;
+
+        /* publish into the ring, then make it visible to readers */
+        uint64_t const index = _count.load(std::memory_order_relaxed);
+        pose.index = index;
+        _history[index % kHistorySize].Store(pose);
+        _count.store(index + 1, std::memory_order_release);
+    }
+}
+
+bool Odometry::LoadSample(uint64_t index, Sample &sample) const
+{
+    _history[index % kHistorySize].Load(sample);
+    return sample.index == index;
+}
+
+std::optional<Odometry::Sample> Odometry::GetLatest() const
+{
+    uint64_t const count = _count.load(std::memory_order_acquire);
+    if (count == 0) return std::nullopt;
+
+    Sample sample;
+    if (!LoadSample(count - 1, sample)) return std::nullopt;
+    return sample;
+}
+
+std::optional<Odometry::Sample> Odometry::GetPoseAt(units::second_t timestamp) const
+{
+    double const time = timestamp.value();
+    uint64_t const count = _count.load(std::memory_order_acquire);
+    if (count == 0) return std::nullopt;
+
+    /* walk back from the newest sample, as most queries are recent */
+    Sample newer;
+    if (!LoadSample(count - 1, newer)) return std::nullopt;
+    if (time >= newer.timestamp) return newer;
+
+    uint64_t const oldest = count > kHistorySize ? count - kHistorySize : 0;
+    for (uint64_t index = count - 1; index-- > oldest;) {
+        Sample older;
+        if (!LoadSample(index, older)) {
+            /* the writer lapped us; the rest is gone */
+            return std::nullopt;
+        }
+        if (time >= older.timestamp) {
+            double const span = newer.timestamp - older.timestamp;
+            double const t = span > 0 ? (time - older.timestamp) / span : 0;
+
+            Sample result = older;
+            result.timestamp = time;
+            result.xMeters += (newer.xMeters - older.xMeters) * t;
+            result.yMeters += (newer.yMeters - older.yMeters) * t;
+            result.headingRadians += (newer.headingRadians - older.headingRadians) * t;
+            result.leftSpeed += (newer.leftSpeed - older.leftSpeed) * t;
+            result.rightSpeed += (newer.rightSpeed - older.rightSpeed) * t;
+            return result;
+        }
+        newer = older;
+    }
+    return std::nullopt;
+}
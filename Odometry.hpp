@@ -0,0 +1,148 @@
+#pragma once
+
+#include "LatencyHistogram.hpp"
+#include "SeqLock.hpp"
+#include "ctre/phoenix6/TalonFX.hpp"
+#include "units/frequency.h"
+#include "units/time.h"
+#include <array>
+#include <atomic>
+#include <optional>
+#include <thread>
+#include <stdint.h>
+
+/**
+ * Estimates the pose of a differential drivetrain on its own
+ * thread, independent of the robot loop period.
+ *
+ * The thread waits on the position and velocity signals of
+ * both leaders at a high update frequency, compensates the
+ * positions for their latency, and integrates the pose from
+ * the wheel travel. Every update is published into a ring of
+ * timestamped samples that any thread can query by time
+ * without locks.
+ *
+ * Both sides must report forward as positive, as set up by
+ * the motor inverts. Timestamps are in the timebase of
+ * ctre::phoenix6::utils::GetCurrentTimeSeconds().
+ */
+class Odometry {
+public:
+    struct Constants {
+        /** Rotor turns per wheel turn */
+        double gearRatio;
+        double wheelRadiusMeters;
+        double trackWidthMeters;
+    };
+
+    /**
+     * The estimated pose of the robot at a point in time.
+     */
+    struct Sample {
+        /** The time the positions were compensated to, in seconds of utils::GetCurrentTimeSeconds() */
+        double timestamp;
+        double xMeters;
+        double yMeters;
+        double headingRadians;
+        double leftSpeed;
+        double rightSpeed;
+        /** Position of the sample in the ring, to detect overwrites */
+        uint64_t index;
+    };
+
+    /**
+     * Update statistics of the odometry thread.
+     */
+    struct Stats {
+        uint64_t updates;
+        /** Number of waits that timed out or failed */
+        uint64_t timeouts;
+        /** Time between consecutive updates */
+        LatencyHistogram::Summary period;
+    };
+
+private:
+    /* about one second of history at 250 Hz */
+    static constexpr size_t kHistorySize = 256;
+
+    /* copies of the device's signals, so this thread never shares them with the robot loop */
+    ctre::phoenix6::StatusSignal<units::turn_t> _leftPosition;
+    ctre::phoenix6::StatusSignal<units::turns_per_second_t> _leftVelocity;
+    ctre::phoenix6::StatusSignal<units::turn_t> _rightPosition;
+    ctre::phoenix6::StatusSignal<units::turns_per_second_t> _rightVelocity;
+
+    Constants const _constants;
+    units::hertz_t _frequency;
+
+    std::array<SeqLock<Sample>, kHistorySize> _history{};
+    std::atomic<uint64_t> _count{0};
+
+    /* a pose to reset to, picked up by the thread when the version changes */
+    SeqLock<Sample> _reset{};
+
+    std::atomic<uint64_t> _timeouts{0};
+    LatencyHistogram _period{};
+
+    std::thread _thread;
+    std::atomic<bool> _running{false};
+
+public:
+    /**
+     * Creates the odometry for the given leaders, updated at
+     * the given frequency once started.
+     */
+    Odometry(ctre::phoenix6::hardware::TalonFX &left, ctre::phoenix6::hardware::TalonFX &right,
+             Constants constants, units::hertz_t frequency = units::hertz_t{250});
+    ~Odometry() { Stop(); }
+
+    Odometry(Odometry const &) = delete;
+    Odometry &operator=(Odometry const &) = delete;
+
+    /**
+     * Raises the update frequency of the signals and starts
+     * the odometry thread.
+     */
+    void Start();
+
+    /**
+     * Stops the odometry thread.
+     */
+    void Stop();
+
+    /**
+     * Resets the pose to the given position and heading, as
+     * of the next update. This may be called from any thread.
+     */
+    void ResetPose(double xMeters, double yMeters, double headingRadians);
+
+    /**
+     * Returns the latest sample, or nothing before the first
+     * update. This may be called from any thread.
+     */
+    std::optional<Sample> GetLatest() const;
+
+    /**
+     * Returns the pose at the given time, interpolated between
+     * the samples around it, or the latest sample if the time
+     * is newer. Returns nothing if the time is older than the
+     * history. This may be called from any thread.
+     */
+    std::optional<Sample> GetPoseAt(units::second_t timestamp) const;
+
+    /**
+     * Returns the update statistics. This may be called from any thread.
+     */
+    Stats GetStats() const
+    {
+        return Stats{
+            _count.load(std::memory_order_relaxed),
+            _timeouts.load(std::memory_order_relaxed),
+            _period.GetSummary(),
+        };
+    }
+
+private:
+    void Run();
+    /** Loads the sample at the given ring position, returning false if it was overwritten. */
+    bool LoadSample(uint64_t index, Sample &sample) const;
+};
@@ -0,0 +1,96 @@
+#include "PeriodicScheduler.hpp"
+#include "SingleWriter.hpp"
+#include <algorithm>
+
+namespace {
+
+std::chrono::nanoseconds ToNanoseconds(units::millisecond_t time)
+{
+    return std::chrono::microseconds{(int64_t)units::microsecond_t{time}.value()};
+}
+
+}
+
+size_t PeriodicScheduler::Add(std::function<void()> callback, units::millisecond_t period, units::millisecond_t offset)
+{
+    auto entry = std::make_unique<Entry>();
+    entry->callback = std::move(callback);
+    entry->period = ToNanoseconds(period);
+    entry->offset = ToNanoseconds(offset);
+    if (_started) {
+        entry->deadline = _now + entry->offset;
+    }
+
+    size_t const handle = _entries.size();
+    _entries.push_back(std::move(entry));
+
+    /* reserve the heap up front, so running the callbacks never allocates */
+    _heap.reserve(_entries.size());
+    if (_started) {
+        _heap.push_back(handle);
+        std::push_heap(_heap.begin(), _heap.end(), [this](size_t a, size_t b) { return Later(a, b); });
+    }
+    return handle;
+}
+
+void PeriodicScheduler::Start(time_point start)
+{
+    _heap.clear();
+    for (size_t i = 0; i < _entries.size(); ++i) {
+        _entries[i]->deadline = start + _entries[i]->offset;
+        _heap.push_back(i);
+    }
+    std::make_heap(_heap.begin(), _heap.end(), [this](size_t a, size_t b) { return Later(a, b); });
+    _now = start;
+    _started = true;
+}
+
+void PeriodicScheduler::RunDue(time_point now)
+{
+    auto const later = [this](size_t a, size_t b) { return Later(a, b); };
+    _now = now;
+
+    while (!_heap.empty() && _entries[_heap.front()]->deadline <= now) {
+        std::pop_heap(_heap.begin(), _heap.end(), later);
+        size_t const index = _heap.back();
+        _heap.pop_back();
+        Entry &entry = *_entries[index];
+
+        auto const start = std::chrono::steady_clock::now();
+        entry.callback();
+        auto const end = std::chrono::steady_clock::now();
+
+        entry.duration.Record(end - start);
+        SingleWriterAdd(entry.runs);
+        if (end - start > entry.period) {
+            entry.overruns.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        /* advance on the original schedule, dropping any deadlines that have already passed;
+         * the schedule is on the caller's clock, while the callback is timed in real time */
+        entry.deadline += entry.period;
+        if (entry.deadline <= now) {
+            auto const missed = (now - entry.deadline) / entry.period + 1;
+            entry.deadline += missed * entry.period;
+            entry.skipped.fetch_add(missed, std::memory_order_relaxed);
+        }
+
+        /* the heap has capacity for every entry, including any the callback added */
+        _heap.push_back(index);
+        std::push_heap(_heap.begin(), _heap.end(), later);
+    }
+}
+
+PeriodicScheduler::Stats PeriodicScheduler::GetStats(size_t handle) const
+{
+    Entry const &entry = *_entries[handle];
+
+    Stats stats{};
+    stats.period = units::microsecond_t{std::chrono::duration_cast<std::chrono::microseconds>(entry.period).count() * 1.0};
+    stats.offset = units::microsecond_t{std::chrono::duration_cast<std::chrono::microseconds>(entry.offset).count() * 1.0};
+    stats.runs = entry.runs.load(std::memory_order_relaxed);
+    stats.overruns = entry.overruns.load(std::memory_order_relaxed);
+    stats.skipped = entry.skipped.load(std::memory_order_relaxed);
+    stats.duration = entry.duration.GetSummary();
+    return stats;
+}
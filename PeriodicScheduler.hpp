@@ -0,0 +1,105 @@
+#pragma once
+
+#include "LatencyHistogram.hpp"
+#include "units/time.h"
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <stdint.h>
+
+/**
+ * Runs callbacks at independent rates on a single thread,
+ * using a heap of absolute deadlines. Each callback runs at
+ * start + offset + k * period, keeps its own overrun
+ * accounting, and never allocates once added. The schedule
+ * follows the times given by the caller, which may be those
+ * of a simulated or replayed timeline.
+ */
+class PeriodicScheduler {
+public:
+    using time_point = std::chrono::steady_clock::time_point;
+
+    /**
+     * Statistics of one callback.
+     */
+    struct Stats {
+        units::millisecond_t period;
+        units::millisecond_t offset;
+        /** Number of times the callback ran */
+        uint64_t runs;
+        /** Number of runs that took longer than the period */
+        uint64_t overruns;
+        /** Number of deadlines dropped because the callback ran too late */
+        uint64_t skipped;
+        /** Execution time of the callback */
+        LatencyHistogram::Summary duration;
+    };
+
+    /**
+     * Adds a callback, returning a handle for GetStats().
+     * This must be called from the thread running the
+     * callbacks, or before they start.
+     */
+    size_t Add(std::function<void()> callback, units::millisecond_t period, units::millisecond_t offset);
+
+    /**
+     * Starts the schedule of every callback at the given time.
+     * Callbacks added later start relative to the latest time
+     * given to Start() or RunDue().
+     */
+    void Start(time_point start);
+
+    /**
+     * Runs every callback whose deadline is at or before now.
+     */
+    void RunDue(time_point now);
+
+    /**
+     * Returns the earliest deadline of any callback, or
+     * time_point::max() if there are no callbacks.
+     */
+    time_point NextDeadline() const
+    {
+        if (_heap.empty()) return time_point::max();
+        return _entries[_heap.front()]->deadline;
+    }
+
+    /**
+     * Returns the number of callbacks.
+     */
+    size_t Size() const { return _entries.size(); }
+
+    /**
+     * Returns statistics of the given callback.
+     * This may be called from any thread.
+     */
+    Stats GetStats(size_t handle) const;
+
+private:
+    struct Entry {
+        std::function<void()> callback;
+        std::chrono::nanoseconds period;
+        std::chrono::nanoseconds offset;
+        time_point deadline;
+
+        std::atomic<uint64_t> runs{0};
+        std::atomic<uint64_t> overruns{0};
+        std::atomic<uint64_t> skipped{0};
+        LatencyHistogram duration;
+    };
+
+    std::vector<std::unique_ptr<Entry>> _entries;
+    /* min-heap of entry indices by deadline */
+    std::vector<size_t> _heap;
+    bool _started = false;
+    /* the latest time given to Start() or RunDue() */
+    time_point _now{};
+
+    /** Orders the heap so the earliest deadline is at the front. */
+    bool Later(size_t a, size_t b) const
+    {
+        return _entries[a]->deadline > _entries[b]->deadline;
+    }
+};
@@ -0,0 +1,187 @@
+#include "RealtimeProfile.hpp"
+#include <alloca.h>
+#include <errno.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <fstream>
+
+namespace {
+
+/** Returns whether the given CPU is in the kernel's isolcpus list. */
+bool IsCpuIsolated(int cpu)
+{
+    std::ifstream file{"/sys/devices/system/cpu/isolated"};
+    std::string list;
+    if (!std::getline(file, list)) return false;
+
+    /* the list is formatted like "2,4-7" */
+    char const *str = list.c_str();
+    while (*str) {
+        char *end;
+        long const first = strtol(str, &end, 10);
+        if (end == str) break;
+
+        long last = first;
+        if (*end == '-') {
+            str = end + 1;
+            last = strtol(str, &end, 10);
+        }
+        if (first <= cpu && cpu <= last) return true;
+
+        str = (*end == ',') ? end + 1 : end;
+    }
+    return false;
+}
+
+/** Touches every page of the given number of bytes of stack. */
+__attribute__((noinline)) void PrefaultStack(size_t bytes)
+{
+    volatile unsigned char *stack = static_cast<volatile unsigned char *>(alloca(bytes));
+    long const pageSize = sysconf(_SC_PAGESIZE);
+    for (size_t i = 0; i < bytes; i += pageSize) {
+        stack[i] = 0;
+    }
+}
+
+std::string ErrnoString(int err)
+{
+    return strerror(err);
+}
+
+}
+
+/*static*/ RealtimeProfile RealtimeProfile::Recommended()
+{
+    RealtimeProfile profile{};
+    profile.priority = 50;
+    profile.lockMemory = true;
+    profile.stackPrefaultBytes = 512 * 1024;
+    profile.heapPrefaultBytes = 8 * 1024 * 1024;
+    profile.timerSlack = 0_us;
+    return profile;
+}
+
+bool RealtimeProfile::IsEmpty() const
+{
+    return priority == 0 && cpus.empty() && !lockMemory &&
+        stackPrefaultBytes == 0 && heapPrefaultBytes == 0 && !timerSlack;
+}
+
+std::vector<RealtimeProfile::Result> RealtimeProfile::Apply() const
+{
+    std::vector<Result> results;
+    char buf[128];
+
+    if (lockMemory) {
+        /* lock memory first so everything we prefault below stays resident */
+        if (mlockall(MCL_CURRENT | MCL_FUTURE) == 0) {
+            results.push_back({"mlockall", true, ""});
+        } else {
+            results.push_back({"mlockall", false, ErrnoString(errno)});
+        }
+    }
+
+    if (heapPrefaultBytes > 0) {
+        snprintf(buf, sizeof(buf), "heap prefault %zu KiB", heapPrefaultBytes / 1024);
+
+        /* never give memory back to the OS, and never satisfy allocations with fresh mmaps */
+        bool const ok = mallopt(M_TRIM_THRESHOLD, -1) && mallopt(M_MMAP_MAX, 0);
+
+        /* fault in the heap once; the freed block stays in the arena for later allocations */
+        auto *heap = static_cast<unsigned char *>(malloc(heapPrefaultBytes));
+        if (ok && heap) {
+            long const pageSize = sysconf(_SC_PAGESIZE);
+            for (size_t i = 0; i < heapPrefaultBytes; i += pageSize) {
+                heap[i] = 0;
+            }
+            results.push_back({buf, true, ""});
+        } else {
+            results.push_back({buf, false, heap ? "mallopt failed" : "allocation failed"});
+        }
+        free(heap);
+    }
+
+    if (stackPrefaultBytes > 0) {
+        snprintf(buf, sizeof(buf), "stack prefault %zu KiB", stackPrefaultBytes / 1024);
+
+        /* leave headroom below the stack limit for the frames already in use */
+        constexpr size_t kStackMargin = 64 * 1024;
+        struct rlimit limit;
+        if (getrlimit(RLIMIT_STACK, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY &&
+            stackPrefaultBytes + kStackMargin > limit.rlim_cur)
+        {
+            results.push_back({buf, false, "exceeds the stack size limit"});
+        } else {
+            PrefaultStack(stackPrefaultBytes);
+            results.push_back({buf, true, ""});
+        }
+    }
+
+    if (timerSlack) {
+        /* a timer slack of 0 resets to the default, so use 1 ns as the minimum */
+        long const slackNs = timerSlack->value() > 0 ? (long)(timerSlack->value() * 1000) : 1;
+        snprintf(buf, sizeof(buf), "timer slack %ld ns", slackNs);
+
+        if (prctl(PR_SET_TIMERSLACK, slackNs, 0, 0, 0) == 0) {
+            results.push_back({buf, true, ""});
+        } else {
+            results.push_back({buf, false, ErrnoString(errno)});
+        }
+    }
+
+    if (!cpus.empty()) {
+        std::string setting = "CPU affinity";
+        std::string isolated;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu : cpus) {
+            setting += " " + std::to_string(cpu);
+            CPU_SET(cpu, &set);
+            if (!IsCpuIsolated(cpu)) {
+                isolated += " " + std::to_string(cpu);
+            }
+        }
+
+        int const err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (err == 0) {
+            results.push_back({setting, true, isolated.empty() ? "isolated" : "not isolated:" + isolated});
+        } else {
+            results.push_back({setting, false, ErrnoString(err)});
+        }
+    }
+
+    if (priority > 0) {
+        snprintf(buf, sizeof(buf), "SCHED_FIFO priority %d", priority);
+
+        struct sched_param param{};
+        param.sched_priority = priority;
+        int const err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (err == 0) {
+            results.push_back({buf, true, ""});
+        } else {
+            results.push_back({buf, false, ErrnoString(err)});
+        }
+    }
+
+    return results;
+}
+
+/*static*/ void RealtimeProfile::PrintResults(std::vector<Result> const &results)
+{
+    printf("Real-time profile:\n");
+    for (auto const &result : results) {
+        printf("    %s: %s%s%s\n",
+                result.setting.c_str(),
+                result.applied ? "applied" : "NOT APPLIED",
+                result.detail.empty() ? "" : " - ",
+                result.detail.c_str());
+    }
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "units/time.h"
+#include <optional>
+#include <string>
+#include <vector>
+#include <stddef.h>
+
+/**
+ * Describes the real-time settings of the thread running
+ * the robot program. Every setting is opt-in, so a default
+ * profile leaves the thread and process untouched.
+ *
+ * Most settings require root or CAP_SYS_NICE/CAP_IPC_LOCK;
+ * settings that could not be applied are reported rather
+ * than treated as fatal.
+ */
+struct RealtimeProfile {
+    /** SCHED_FIFO priority from 1 to 99, or 0 to keep SCHED_OTHER */
+    int priority = 0;
+    /** CPUs the thread may run on, or empty to keep the current affinity */
+    std::vector<int> cpus;
+    /** Whether to lock all current and future memory into RAM */
+    bool lockMemory = false;
+    /** Bytes of stack to fault in up front */
+    size_t stackPrefaultBytes = 0;
+    /** Bytes of heap to fault in up front and keep reserved for later allocations */
+    size_t heapPrefaultBytes = 0;
+    /** Timer slack of the thread, where 0 requests the smallest possible slack */
+    std::optional<units::microsecond_t> timerSlack;
+
+    /**
+     * Returns a profile suitable for a robot computer
+     * dedicated to the robot program: SCHED_FIFO priority 50,
+     * locked and prefaulted memory, and minimal timer slack.
+     * The CPU affinity is left to the user, as it depends on
+     * the kernel's isolcpus configuration.
+     */
+    static RealtimeProfile Recommended();
+
+    /**
+     * Returns whether this profile changes anything.
+     */
+    bool IsEmpty() const;
+
+    /**
+     * The outcome of applying one setting of the profile.
+     */
+    struct Result {
+        /** Description of the requested setting */
+        std::string setting;
+        /** Whether the setting took effect */
+        bool applied;
+        /** Reason for a failure, or additional information */
+        std::string detail;
+    };
+
+    /**
+     * Applies this profile to the calling thread and process,
+     * returning the outcome of every requested setting.
+     */
+    std::vector<Result> Apply() const;
+
+    /**
+     * Prints the outcome of applying a profile.
+     */
+    static void PrintResults(std::vector<Result> const &results);
+};
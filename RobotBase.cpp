@@ -1,75 +1,550 @@
 #include "RobotBase.hpp"
-#include "ctre/phoenix6/unmanaged/Unmanaged.hpp" // for FeedEnable
+#include <algorithm>
+#include <errno.h>
+#include <time.h>
+
+namespace {
+
+/**
+ * The monotonic clock, with absolute-deadline sleeps.
+ */
+class SteadyLoopClock final : public LoopClock {
+public:
+    time_point Now() override { return std::chrono::steady_clock::now(); }
+
+    void SleepUntil(time_point deadline, units::microsecond_t spin) override
+    {
+        RobotBase::SleepUntil(deadline, spin);
+    }
+};
+
+SteadyLoopClock s_steadyClock;
+
+}
+
+RobotBase::RobotBase() : _clock{&s_steadyClock} {}
 
 int RobotBase::Run()
 {
     printf("Starting robot program...\n");
 
+    /* start the telemetry writer first, so it does not inherit the real-time profile */
+    _telemetry.Start(_telemetryPath);
+    if (!_tracePath.empty()) {
+        _tracer.Start(_tracePath);
+    }
+    Tracer::SetThreadTracer(&_tracer);
+    StartHotPathGuard();
+    if (!_sharedStateName.empty() && _sharedState.Open(_sharedStateName.c_str())) {
+        _enabledEntry = _sharedState.AddEntry("loop.enabled", SharedState::Type::Bool);
+        _cyclesEntry = _sharedState.AddEntry("loop.cycles", SharedState::Type::Int64);
+        _cycleDurationEntry = _sharedState.AddEntry("loop.cycleUs", SharedState::Type::Double);
+        _periodEntry = _sharedState.AddEntry("loop.periodUs", SharedState::Type::Double);
+        _overrunsEntry = _sharedState.AddEntry("loop.overruns", SharedState::Type::Int64);
+    }
+
+    /* apply the real-time profile first, so robot init runs in locked memory */
+    if (!_realtimeProfile.IsEmpty() && !_simulating) {
+        RealtimeProfile::PrintResults(_realtimeProfile.Apply());
+    }
+
     /* this is robot startup, run robot init */
     RobotInit();
+    if (_simulating) {
+        SimulationInit();
+    }
+    StartRecording();
+
+    /* the supervisor owns the enable from here on; a replay never drives the devices */
+    if (!_replaying) {
+        /* in signal-synchronous mode, heartbeats can be as far apart as the sync timeout */
+        units::millisecond_t heartbeatPeriod = _loopTime;
+        if (!_syncSignals.empty() && !_simulating && _syncTimeout > heartbeatPeriod) {
+            heartbeatPeriod = _syncTimeout;
+        }
+        _enableSupervisor.Start(_enableSettings, heartbeatPeriod);
+    }
+
+    LoopClock &clock = *_clock;
+
+    std::chrono::nanoseconds const period{std::chrono::microseconds{(int64_t)units::microsecond_t{_loopTime}.value()}};
+
+    /* the first cycle runs immediately, and the added periodic callbacks are offset from it */
+    auto deadline = clock.Now();
+    _periodic.Start(deadline);
+    auto const loopStart = deadline;
+    auto lastStart = deadline;
+    bool firstCycle = true;
+
+    /* in signal-synchronous mode, the deadline is when we fall back to the timer;
+     * simulated time does not pass while waiting on signals, so simulation always uses the timer */
+    bool const signalSync = !_syncSignals.empty() && !_simulating;
+    std::chrono::nanoseconds const syncTimeout = _syncTimeout > 0_ms ?
+        std::chrono::nanoseconds{std::chrono::microseconds{(int64_t)units::microsecond_t{_syncTimeout}.value()}} :
+        period;
+    bool signalsArrived = false;
+    /* whether the CatchUp policy is running the cycles missed by an overrun */
+    bool catchingUp = false;
 
     while (IsRunning()) {
-        auto const start = std::chrono::steady_clock::now();
+        auto const start = clock.Now();
+        if (_simulating && start - loopStart >= _simulationDuration) break;
 
-        /* run the robot periodic function */
-        RobotPeriodic();
+        if (signalsArrived || start >= deadline) {
+            if (!firstCycle) {
+                RecordPeriod(start - lastStart);
+                _sharedState.Publish(_periodEntry, (start - lastStart).count() / 1e3);
+            }
+            lastStart = start;
+            firstCycle = false;
+            _cycleTime = start - loopStart;
+            _telemetry.SetTime(_cycleTime);
+            _sharedState.SetTime(_cycleTime);
+            _tracer.BeginCycle();
 
-        /* check if we're enabled */
-        if (IsEnabled()) {
-            /* enabled */
-            if (_lastEnabled != 1) {
-                /* just switched, run enabled init */
-                printf("Robot ENABLED\n");
-                EnabledInit();
-                _lastEnabled = 1;
+            if (_simulating) {
+                SimulationPeriodic();
             }
 
-            /* enable for 100 ms */
-            ctre::phoenix::unmanaged::FeedEnable(100);
-            /* run enabled periodic */
-            EnabledPeriodic();
-        } else {
-            /* disabled */
-            if (_lastEnabled != 0) {
-                /* just switched, run disabled init */
-                printf("Robot DISABLED\n");
-                DisabledInit();
-                _lastEnabled = 0;
+            /* the cycle's cost is always measured in real time */
+            auto const cycleStart = std::chrono::steady_clock::now();
+            RunCycle();
+            auto const cycleEnd = std::chrono::steady_clock::now();
+            RecordPhase(LoopPhase::Cycle, cycleEnd - cycleStart);
+            _tracer.Record("Cycle", cycleStart, cycleEnd);
+            _sharedState.Publish(_enabledEntry, _lastEnabled == 1);
+            _sharedState.Publish(_cyclesEntry, ++_cycles);
+            _sharedState.Publish(_cycleDurationEntry, (cycleEnd - cycleStart).count() / 1e3);
+            ReportHotPathViolations();
+
+            auto const end = clock.Now();
+
+            if (_recorder.IsOpen()) {
+                _recorder.Write(_cycleTime, _lastEnabled == 1, _loggedInputs.data());
             }
+            units::millisecond_t const dtMs{std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0};
 
-            /* run disabled periodic */
-            DisabledPeriodic();
+            if (signalSync) {
+                /* wait for the next set of signals, up to the timeout */
+                deadline = start + syncTimeout;
+                signalsArrived = false;
+                if (end - start > period) {
+                    /* loop overrun */
+                    _overruns.fetch_add(1, std::memory_order_relaxed);
+                    ReportLoopOverrun(dtMs);
+                }
+            } else if (_schedulingMode == SchedulingMode::Relative) {
+                /* wait for the remainder of the loop time */
+                deadline = start + period;
+                if (end > deadline) {
+                    /* loop overrun */
+                    _overruns.fetch_add(1, std::memory_order_relaxed);
+                    ReportLoopOverrun(dtMs);
+                    /* yield control of this thread */
+                    SleepFor(0_ms);
+                }
+            } else {
+                /* advance the schedule by exactly one period, independent of when we woke up */
+                deadline += period;
+                if (end > deadline) {
+                    /* a make-up cycle is late because of the overrun before it, so it only counts if it overran itself */
+                    if (!catchingUp || end - start > period) {
+                        /* loop overrun */
+                        _overruns.fetch_add(1, std::memory_order_relaxed);
+                        ReportLoopOverrun(dtMs);
+                    }
+
+                    if (_overrunPolicy == OverrunPolicy::Skip) {
+                        /* drop every deadline that has already passed, staying on the original schedule */
+                        auto const missed = (end - deadline) / period + 1;
+                        deadline += missed * period;
+                        _skipped.fetch_add(missed, std::memory_order_relaxed);
+                    } else {
+                        /* catch up: the deadline is in the past, so the next cycle starts immediately */
+                        catchingUp = true;
+                    }
+                } else {
+                    catchingUp = false;
+                }
+            }
+            _sharedState.Publish(_overrunsEntry, _overruns.load(std::memory_order_relaxed));
+        }
+
+        /* run any added periodic callbacks that are due */
+        {
+            HotPathGuard::Scope const guard{"PeriodicCallbacks"};
+            _periodic.RunDue(clock.Now());
         }
 
-        auto const end = std::chrono::steady_clock::now();
+        /* wait until the robot loop or a periodic callback is due next */
+        auto const wakeTime = std::min(deadline, _periodic.NextDeadline());
+        auto const now = clock.Now();
+        if (wakeTime <= now) continue;
 
-        /* yield for the remainder of the loop time */
-        units::millisecond_t const dtMs{std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0};
-        if (dtMs < _loopTime) {
-            SleepFor(_loopTime - dtMs);
+        if (signalSync) {
+            /* block until all the signals have new data; this also refreshes them */
+            units::second_t const timeout{std::chrono::duration<double>(wakeTime - now).count()};
+            signalsArrived = ctre::phoenix6::BaseStatusSignal::WaitForAll(timeout, _syncSignals).IsOK();
+            if (!signalsArrived) {
+                /* the wait can also fail early (such as for signals on different buses), so wait out the timer */
+                clock.SleepUntil(wakeTime, 0_us);
+                if (clock.Now() >= deadline) {
+                    /* the signals are late, fall back to the timer */
+                    _signalTimeouts.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
         } else {
-            /* loop overrun */
-            ReportLoopOverrun(dtMs);
-            /* yield control of this thread */
-            SleepFor(0_ms);
+            clock.SleepUntil(wakeTime, _schedulingMode == SchedulingMode::AbsoluteDeadline ? _spinTime : 0_us);
+            RecordPhase(LoopPhase::WakeupError, clock.Now() - wakeTime);
         }
     }
 
     /* program shutting down */
+    _enableSupervisor.Stop();
+    Tracer::SetThreadTracer(nullptr);
+    _tracer.Stop();
+    _telemetry.Stop();
+    /* after the telemetry, so the report follows the warnings */
+    StopHotPathGuard();
+    _sharedState.Close();
     printf("Stopping robot program...\n");
+    _recorder.Close();
 
     return 0;
 }
 
+int RobotBase::Replay(char const *path)
+{
+    InputReplayer replayer;
+    if (!replayer.Open(path)) return 1;
+
+    printf("Replaying %zu cycles from %s...\n", replayer.GetNumRecords(), path);
+    _replaying = true;
+    _loopTime = replayer.GetLoopTime();
+    _telemetry.Start(_telemetryPath);
+    StartHotPathGuard();
+
+    /* this is robot startup, run robot init */
+    RobotInit();
+
+    if (replayer.GetNumInputs() != _numLoggedInputs) {
+        fprintf(stderr, "Error: The recording has %zu inputs, but the robot logs %zu\n",
+                replayer.GetNumInputs(), _numLoggedInputs);
+        _telemetry.Stop();
+        StopHotPathGuard();
+        return 1;
+    }
+
+    /* periodic callbacks run on the recorded timeline */
+    std::chrono::steady_clock::time_point const timeline{};
+    _periodic.Start(timeline);
+
+    uint64_t divergences = 0;
+    auto const replayStart = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < replayer.GetNumRecords() && IsRunning(); ++i) {
+        auto const record = replayer.GetRecord(i);
+        std::copy(record.inputs, record.inputs + _numLoggedInputs, _externalInputs.begin());
+        _cycleTime = record.timestamp;
+        _telemetry.SetTime(_cycleTime);
+
+        auto const start = std::chrono::steady_clock::now();
+        RunCycle();
+        RecordPhase(LoopPhase::Cycle, std::chrono::steady_clock::now() - start);
+
+        {
+            HotPathGuard::Scope const guard{"PeriodicCallbacks"};
+            _periodic.RunDue(timeline + record.timestamp);
+        }
+        ReportHotPathViolations();
+
+        if ((_lastEnabled == 1) != record.enabled) {
+            /* report the first few, the rest are usually the same cause */
+            if (divergences < 10) {
+                _telemetry.Print(stderr, "Warning: Cycle %zu at %.3fs was %s in the recording, but %s in replay\n",
+                        i, GetCycleTime().value(),
+                        record.enabled ? "enabled" : "disabled",
+                        record.enabled ? "disabled" : "enabled");
+            }
+            ++divergences;
+        }
+    }
+    double const elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - replayStart).count();
+    _telemetry.Stop();
+    bool const hotPathClean = StopHotPathGuard();
+
+    printf("Replayed %.3fs of robot time in %.3fs, %llu divergent cycles\n",
+            GetCycleTime().value(), elapsed, (unsigned long long)divergences);
+    PrintLoopStats();
+
+    _replaying = false;
+    return divergences == 0 && hotPathClean ? 0 : 1;
+}
+
+int RobotBase::RunSimulation(units::second_t duration)
+{
+    SimulatedClock clock;
+    LoopClock *const previousClock = _clock;
+    _clock = &clock;
+    _simulating = true;
+    _simulationDuration = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<double>{duration.value()});
+
+    printf("Simulating %.1fs...\n", duration.value());
+    auto const wallStart = std::chrono::steady_clock::now();
+    int result = Run();
+    double const elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+
+    printf("Simulated %.3fs of robot time in %.3fs (%.0fx real time)\n",
+            GetCycleTime().value(), elapsed, elapsed > 0 ? GetCycleTime().value() / elapsed : 0.0);
+    PrintLoopStats();
+
+    auto const hotPath = GetHotPathStats();
+    if (hotPath.allocations > 0 || hotPath.blockingCalls > 0) {
+        result = 1;
+    }
+
+    _simulating = false;
+    _clock = previousClock;
+    return result;
+}
+
+void RobotBase::StartRecording()
+{
+    if (_recordingPath.empty()) return;
+
+    if (_recorder.Open(_recordingPath.c_str(), _numLoggedInputs, _loopTime, _recordingDuration)) {
+        _telemetry.Print(stdout, "Recording %zu inputs to %s\n", _numLoggedInputs, _recordingPath.c_str());
+    }
+}
+
+void RobotBase::StartHotPathGuard()
+{
+    _reportedHotPathSites = _hotPathGuard.GetNumSites();
+    HotPathGuard::SetThreadGuard(&_hotPathGuard);
+    _hotPathGuard.SetMode(_hotPathMode, _checkBlocking);
+}
+
+void RobotBase::ReportHotPathViolations()
+{
+    /* this runs outside of the guarded calls, so naming the call sites may allocate */
+    for (; _reportedHotPathSites < _hotPathGuard.GetNumSites(); ++_reportedHotPathSites) {
+        auto const &site = _hotPathGuard.GetSite(_reportedHotPathSites);
+        if (site.numFrames == 0) {
+            _telemetry.Print(stderr, "Warning: %s blocked the robot loop\n", site.scope);
+            continue;
+        }
+        _telemetry.Print(stderr, "Warning: Heap allocation of %zu bytes in %s, from:\n", site.size, site.scope);
+        /* the innermost frames find the call site, and the report at the end has the rest */
+        for (size_t i = 0; i < site.numFrames && i < kReportedFrames; ++i) {
+            /* leave room for the frame number, so long names are cut off instead of the newline */
+            char name[Telemetry::kMaxMessageLength - 16];
+            HotPathGuard::GetFrameName(site.frames[i], name, sizeof(name));
+            _telemetry.Print(stderr, "    #%zu %s\n", i, name);
+        }
+    }
+}
+
+bool RobotBase::StopHotPathGuard()
+{
+    HotPathGuard::SetThreadGuard(nullptr);
+    if (!_hotPathGuard.IsActive()) return true;
+
+    _hotPathGuard.SetMode(HotPathGuard::Mode::Off);
+    _hotPathGuard.PrintReport();
+    auto const stats = _hotPathGuard.GetStats();
+    return stats.allocations == 0 && stats.blockingCalls == 0;
+}
+
+void RobotBase::RunCycle()
+{
+    _cyclePhases.fill({});
+
+    auto t = std::chrono::steady_clock::now();
+    /* records the time since the end of the last phase */
+    auto const endPhase = [&](LoopPhase phase) {
+        auto const now = std::chrono::steady_clock::now();
+        RecordPhase(phase, now - t);
+        _tracer.Record(GetLoopPhaseName(phase), t, now);
+        t = now;
+    };
+
+    /* run the robot periodic function */
+    {
+        HotPathGuard::Scope const guard{GetLoopPhaseName(LoopPhase::RobotPeriodic)};
+        RobotPeriodic();
+    }
+    endPhase(LoopPhase::RobotPeriodic);
+
+#if ROBOT_COMMANDS
+    /* run the commands that are ready, on robot time so they replay and simulate exactly */
+    {
+        HotPathGuard::Scope const guard{GetLoopPhaseName(LoopPhase::Commands)};
+        _commands.Tick(GetCycleTime());
+    }
+    endPhase(LoopPhase::Commands);
+#endif
+
+    /* check if we're enabled */
+    bool enabled;
+    {
+        HotPathGuard::Scope const guard{GetLoopPhaseName(LoopPhase::IsEnabled)};
+        enabled = IsEnabled();
+    }
+    endPhase(LoopPhase::IsEnabled);
+
+    if (enabled) {
+        /* enabled */
+        if (_lastEnabled != 1) {
+            /* just switched, run enabled init */
+            _telemetry.Print(stdout, "Robot ENABLED\n");
+            EnabledInit();
+            _lastEnabled = 1;
+            endPhase(LoopPhase::ModeTransition);
+        }
+
+        /* keep the enable supervisor feeding the enable */
+        _enableSupervisor.Heartbeat(true);
+        if (_enableSupervisor.GetLapses() != _reportedLapses) {
+            _reportedLapses = _enableSupervisor.GetLapses();
+            _telemetry.Print(stderr, "Warning: Enable dropped after the robot loop stalled for %.1fms\n",
+                    _enableSupervisor.GetLastLapseAge().value());
+        }
+        endPhase(LoopPhase::Heartbeat);
+
+        /* run enabled periodic */
+        {
+            HotPathGuard::Scope const guard{GetLoopPhaseName(LoopPhase::EnabledPeriodic)};
+            EnabledPeriodic();
+        }
+        endPhase(LoopPhase::EnabledPeriodic);
+    } else {
+        /* disabled, so let the enable lapse */
+        _enableSupervisor.Heartbeat(false);
+
+        if (_lastEnabled != 0) {
+            /* just switched, run disabled init */
+            _telemetry.Print(stdout, "Robot DISABLED\n");
+#if ROBOT_COMMANDS
+            _commands.OnDisabled();
+#endif
+            DisabledInit();
+            _lastEnabled = 0;
+            endPhase(LoopPhase::ModeTransition);
+        }
+
+        /* run disabled periodic */
+        {
+            HotPathGuard::Scope const guard{GetLoopPhaseName(LoopPhase::DisabledPeriodic)};
+            DisabledPeriodic();
+        }
+        endPhase(LoopPhase::DisabledPeriodic);
+    }
+}
+
+/*static*/ void RobotBase::SleepUntil(std::chrono::steady_clock::time_point deadline, units::microsecond_t spin)
+{
+    /* steady_clock is CLOCK_MONOTONIC on Linux, so its time points can be passed straight to the kernel */
+    auto const wakeTime = deadline - std::chrono::microseconds{(int64_t)spin.value()};
+    auto const ns = std::chrono::duration_cast<std::chrono::nanoseconds>(wakeTime.time_since_epoch()).count();
+
+    if (ns > 0) {
+        struct timespec ts;
+        ts.tv_sec = ns / 1000000000;
+        ts.tv_nsec = ns % 1000000000;
+
+        /* an absolute sleep can simply be restarted after a signal */
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {}
+    }
+
+    /* spin for the remainder of the time */
+    while (std::chrono::steady_clock::now() < deadline) {}
+}
+
+void RobotBase::RecordPeriod(std::chrono::nanoseconds period)
+{
+    std::chrono::nanoseconds const loopTime{std::chrono::microseconds{(int64_t)units::microsecond_t{_loopTime}.value()}};
+    RecordPhase(LoopPhase::PeriodJitter, period > loopTime ? period - loopTime : loopTime - period);
+}
+
+RobotBase::JitterStats RobotBase::GetJitterStats() const
+{
+    auto const summary = GetLoopStats(LoopPhase::PeriodJitter);
+
+    JitterStats stats{};
+    stats.samples = summary.count;
+    stats.mean = summary.mean;
+    stats.p99 = summary.p99;
+    stats.max = summary.max;
+    stats.overruns = _overruns.load(std::memory_order_relaxed);
+    stats.skipped = _skipped.load(std::memory_order_relaxed);
+    return stats;
+}
+
+/*static*/ char const *RobotBase::GetLoopPhaseName(LoopPhase phase)
+{
+    switch (phase) {
+        case LoopPhase::RobotPeriodic: return "RobotPeriodic";
+        case LoopPhase::Commands: return "Commands";
+        case LoopPhase::IsEnabled: return "IsEnabled";
+        case LoopPhase::ModeTransition: return "ModeTransition";
+        case LoopPhase::Heartbeat: return "Heartbeat";
+        case LoopPhase::EnabledPeriodic: return "EnabledPeriodic";
+        case LoopPhase::DisabledPeriodic: return "DisabledPeriodic";
+        case LoopPhase::Cycle: return "Cycle";
+        case LoopPhase::WakeupError: return "WakeupError";
+        case LoopPhase::PeriodJitter: return "PeriodJitter";
+    }
+    return "Unknown";
+}
+
+void RobotBase::PrintLoopStats(FILE *file) const
+{
+    fprintf(file, "%-17s %10s %10s %10s %10s %10s %10s\n",
+            "Phase (us)", "count", "min", "p50", "p99", "p99.9", "max");
+    for (size_t i = 0; i < kNumLoopPhases; ++i) {
+        auto const phase = static_cast<LoopPhase>(i);
+        auto const summary = GetLoopStats(phase);
+        fprintf(file, "%-17s %10llu %10.1f %10.1f %10.1f %10.1f %10.1f\n",
+                GetLoopPhaseName(phase), (unsigned long long)summary.count,
+                summary.min.value(), summary.p50.value(), summary.p99.value(),
+                summary.p999.value(), summary.max.value());
+    }
+
+    for (size_t i = 0; i < _periodic.Size(); ++i) {
+        auto const stats = GetPeriodicStats(i);
+        fprintf(file, "Periodic %-5zu     %10llu %10.1f %10.1f %10.1f %10.1f %10.1f  (%.1fms, %llu overruns, %llu skipped)\n",
+                i, (unsigned long long)stats.runs,
+                stats.duration.min.value(), stats.duration.p50.value(), stats.duration.p99.value(),
+                stats.duration.p999.value(), stats.duration.max.value(),
+                stats.period.value(), (unsigned long long)stats.overruns, (unsigned long long)stats.skipped);
+    }
+}
+
+size_t RobotBase::AddPeriodic(std::function<void()> callback, units::millisecond_t period, units::millisecond_t offset)
+{
+    return _periodic.Add(std::move(callback), period, offset);
+}
+
 void RobotBase::ReportLoopOverrun(units::millisecond_t measured)
 {
+    /* keep the spans of this cycle and the ones before it */
+    _tracer.RequestDump();
+
     auto const now = std::chrono::steady_clock::now();
     auto const dtMs = std::chrono::duration_cast<std::chrono::milliseconds>(now - _lastErrorTime).count();
 
     if (dtMs > kErrorTimeMs) {
-        fprintf(stderr, "Warning: %.1fms loop time overrun\n"
+        _telemetry.Print(stderr, "Warning: %.1fms loop time overrun\n"
                 "    Robot loop took %.3fms\n",
                 _loopTime.value(), measured.value());
+
+        /* break the cycle down into the phases that ran */
+        for (size_t i = 0; i < kNumLoopPhases; ++i) {
+            auto const phase = static_cast<LoopPhase>(i);
+            if (phase == LoopPhase::Cycle || _cyclePhases[i].count() == 0) continue;
+            if (phase == LoopPhase::WakeupError || phase == LoopPhase::PeriodJitter) continue;
+
+            _telemetry.Print(stderr, "        %s: %.3fms\n", GetLoopPhaseName(phase), _cyclePhases[i].count() / 1e6);
+        }
         _lastErrorTime = now;
     }
 }
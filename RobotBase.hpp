@@ -1,9 +1,29 @@
 #pragma once
 
+#include "Commands.hpp"
+#include "EnableSupervisor.hpp"
+#include "HotPathGuard.hpp"
+#include "InputDevice.hpp"
+#include "InputLog.hpp"
+#include "LatencyHistogram.hpp"
+#include "LoopClock.hpp"
+#include "PeriodicScheduler.hpp"
+#include "RealtimeProfile.hpp"
+#include "SharedState.hpp"
+#include "Telemetry.hpp"
+#include "Trace.hpp"
+#include "ctre/phoenix6/StatusSignal.hpp"
 #include "units/time.h"
+#include <array>
+#include <atomic>
 #include <chrono>
+#include <functional>
+#include <string>
 #include <thread>
+#include <utility>
+#include <vector>
 #include <stdint.h>
+#include <stdio.h>
 
 /**
  * Manages a robot program.
@@ -22,11 +42,153 @@ public:
 
     virtual bool IsRunning() { return true; }
 
+    /** Runs once in simulation, after RobotInit */
+    virtual void SimulationInit() {}
+    /** Runs in simulation at the start of every cycle, to step physics and set inputs */
+    virtual void SimulationPeriodic() {}
+
+    /**
+     * How the robot loop schedules its periodic calls.
+     */
+    enum class SchedulingMode {
+        /**
+         * Sleeps for the remainder of the loop time after each
+         * cycle. Wake-up latency accumulates, so the loop drifts.
+         */
+        Relative,
+        /**
+         * Wakes on absolute deadlines of the monotonic clock,
+         * so wake-up latency never accumulates into drift.
+         */
+        AbsoluteDeadline,
+    };
+
+    /**
+     * What the AbsoluteDeadline scheduler does with the
+     * deadlines that were missed by an overrunning cycle.
+     */
+    enum class OverrunPolicy {
+        /**
+         * Runs the missed cycles back-to-back until the loop
+         * has caught up with the original schedule.
+         */
+        CatchUp,
+        /**
+         * Drops the missed cycles and resumes on the next
+         * deadline of the original schedule.
+         */
+        Skip,
+    };
+
+    /**
+     * Individually timed phases of the robot loop.
+     */
+    enum class LoopPhase {
+        RobotPeriodic,
+        /** Ticking the command scheduler */
+        Commands,
+        IsEnabled,
+        /** EnabledInit or DisabledInit, on a mode transition */
+        ModeTransition,
+        /** Sending the enable supervisor its heartbeat */
+        Heartbeat,
+        EnabledPeriodic,
+        DisabledPeriodic,
+        /** The whole cycle, from RobotPeriodic to the end of the mode's periodic function */
+        Cycle,
+        /** How late the loop woke up relative to when it asked to */
+        WakeupError,
+        /** The absolute difference between the start-to-start period and the loop time */
+        PeriodJitter,
+    };
+    static constexpr size_t kNumLoopPhases = 10;
+
+    /**
+     * Statistics of the measured loop period, where the
+     * jitter of a cycle is the absolute difference between
+     * its start-to-start period and the loop time.
+     */
+    struct JitterStats {
+        /** Number of measured periods */
+        uint64_t samples;
+        /** Mean jitter */
+        units::microsecond_t mean;
+        /** 99th percentile jitter, to within about 3% */
+        units::microsecond_t p99;
+        /** Largest jitter seen */
+        units::microsecond_t max;
+        /** Number of cycles that finished past their deadline */
+        uint64_t overruns;
+        /** Number of deadlines dropped by OverrunPolicy::Skip */
+        uint64_t skipped;
+    };
+
 private:
     units::millisecond_t _loopTime = 20_ms;
     int _lastEnabled = -1;
 
+    SchedulingMode _schedulingMode = SchedulingMode::AbsoluteDeadline;
+    OverrunPolicy _overrunPolicy = OverrunPolicy::Skip;
+    units::microsecond_t _spinTime = 0_us;
+
+    RealtimeProfile _realtimeProfile{};
+
+    std::vector<ctre::phoenix6::BaseStatusSignal *> _syncSignals;
+    units::millisecond_t _syncTimeout = 0_ms;
+
+    PeriodicScheduler _periodic{};
+
+    /* inputs captured by the recorder and fed by replay */
+    static constexpr size_t kMaxLoggedInputs = 4;
+    std::array<InputState const *, kMaxLoggedInputs> _loggedInputs{};
+    /* the logged inputs as fed by replay or simulation */
+    std::array<InputState, kMaxLoggedInputs> _externalInputs{};
+    size_t _numLoggedInputs = 0;
+
+    std::string _recordingPath;
+    units::second_t _recordingDuration = 30_min;
+    InputRecorder _recorder{};
+    bool _replaying = false;
+    std::chrono::nanoseconds _cycleTime{0};
+
+    LoopClock *_clock;
+    bool _simulating = false;
+    std::chrono::nanoseconds _simulationDuration{0};
+
+    std::string _telemetryPath;
+    Telemetry _telemetry{};
+
+    std::string _tracePath;
+    Tracer _tracer{};
+
+    HotPathGuard _hotPathGuard{};
+    HotPathGuard::Mode _hotPathMode = HotPathGuard::Mode::Off;
+    bool _checkBlocking = false;
+    size_t _reportedHotPathSites = 0;
+    /* call stack frames of each new violation printed by the loop */
+    static constexpr size_t kReportedFrames = 5;
+
+    std::string _sharedStateName;
+    SharedStatePublisher _sharedState{};
+    /* the loop timing published to the shared state */
+    SharedStatePublisher::Entry _enabledEntry = SharedStatePublisher::kInvalidEntry;
+    SharedStatePublisher::Entry _cyclesEntry = SharedStatePublisher::kInvalidEntry;
+    SharedStatePublisher::Entry _cycleDurationEntry = SharedStatePublisher::kInvalidEntry;
+    SharedStatePublisher::Entry _periodEntry = SharedStatePublisher::kInvalidEntry;
+    SharedStatePublisher::Entry _overrunsEntry = SharedStatePublisher::kInvalidEntry;
+    uint64_t _cycles = 0;
+
+#if ROBOT_COMMANDS
+    CommandScheduler _commands{};
+#endif
+
+    EnableSupervisor::Settings _enableSettings{};
+    EnableSupervisor _enableSupervisor{};
+    uint64_t _reportedLapses = 0;
+
 public:
+    RobotBase();
+
     /**
      * Sleeps for the specified amount of time.
      */
@@ -35,6 +197,13 @@ public:
         std::this_thread::sleep_for(std::chrono::microseconds{(uint64_t)us.value()});
     }
 
+    /**
+     * Sleeps until the given absolute deadline of the monotonic
+     * clock, busy-waiting for the final spin time to hide the
+     * wake-up latency of the kernel.
+     */
+    static void SleepUntil(std::chrono::steady_clock::time_point deadline, units::microsecond_t spin = 0_us);
+
     /**
      * Sets the loop time for the robot program periodic calls.
      */
@@ -43,15 +212,351 @@ public:
         _loopTime = loopTime;
     }
 
+    /**
+     * Returns the loop time for the robot program periodic calls.
+     */
+    units::millisecond_t GetLoopTime() const { return _loopTime; }
+
+    /**
+     * Sets how the robot loop schedules its periodic calls.
+     */
+    void SetSchedulingMode(SchedulingMode mode = SchedulingMode::AbsoluteDeadline)
+    {
+        _schedulingMode = mode;
+    }
+
+    /**
+     * Sets what the AbsoluteDeadline scheduler does after a loop overrun.
+     */
+    void SetOverrunPolicy(OverrunPolicy policy = OverrunPolicy::Skip)
+    {
+        _overrunPolicy = policy;
+    }
+
+    /**
+     * Sets how long the AbsoluteDeadline scheduler busy-waits
+     * before each deadline. Spinning trades CPU time for lower
+     * wake-up jitter; 50-100 us is typical on a loaded system.
+     */
+    void SetSpinTime(units::microsecond_t spin = 0_us)
+    {
+        _spinTime = spin;
+    }
+
+    /**
+     * Runs the robot loop as soon as all the given status
+     * signals have received new data, instead of on a timer,
+     * so the periodic functions act on the freshest sensor
+     * data. The signals are refreshed by the wait, and their
+     * update frequency sets the loop rate.
+     *
+     * If the signals do not all arrive within the timeout,
+     * the loop runs anyway, falling back to a timer with the
+     * timeout as its period. A timeout of 0 uses the loop time.
+     *
+     * Pass an empty list to return to timer-driven scheduling.
+     */
+    void SetSynchronousSignals(std::vector<ctre::phoenix6::BaseStatusSignal *> signals, units::millisecond_t timeout = 0_ms)
+    {
+        _syncSignals = std::move(signals);
+        _syncTimeout = timeout;
+    }
+
+    /**
+     * Returns the number of robot loops that ran on the
+     * timer fallback because the synchronous signals did not
+     * arrive in time. This may be called from any thread.
+     */
+    uint64_t GetSignalTimeouts() const
+    {
+        return _signalTimeouts.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Sets the real-time profile applied to the thread
+     * running the robot program when Run() starts.
+     */
+    void SetRealtimeProfile(RealtimeProfile profile)
+    {
+        _realtimeProfile = std::move(profile);
+    }
+
+    /**
+     * Sets the thresholds of the enable supervisor, which feeds
+     * the device enable on its own thread while the robot loop
+     * keeps up its heartbeats. This must be called before Run().
+     */
+    void SetEnableSupervision(EnableSupervisor::Settings settings)
+    {
+        _enableSettings = settings;
+    }
+
+    /**
+     * Returns the statistics of the enable supervisor.
+     * This may be called from any thread.
+     */
+    EnableSupervisor::Stats GetEnableStats() const
+    {
+        return _enableSupervisor.GetStats();
+    }
+
+    /**
+     * Logs the raw state of the given input device in every
+     * cycle of a recording, and feeds it the recorded state
+     * during replay. Call this from RobotInit(), in the same
+     * order every time. In simulation, the device reads the
+     * state set through GetSimulatedInput().
+     */
+    template <typename Backend>
+    void AddLoggedInput(InputDevice<Backend> &device)
+    {
+        if (_numLoggedInputs >= kMaxLoggedInputs) {
+            fprintf(stderr, "Warning: Only %zu inputs can be logged, ignoring port %d\n",
+                    kMaxLoggedInputs, device.GetPort());
+            return;
+        }
+        _loggedInputs[_numLoggedInputs] = &device.GetRawState();
+        if (_replaying || _simulating) {
+            device.SetStateSource(&_externalInputs[_numLoggedInputs]);
+        }
+        ++_numLoggedInputs;
+    }
+
+    /**
+     * Records every cycle of Run() to the given file: its
+     * timestamp, whether the robot was enabled, and the state
+     * of each logged input. See Replay(). The file is allocated
+     * up front for the expected duration of the run; running
+     * longer costs an occasional stall while the file grows.
+     */
+    void SetRecordingFile(std::string path, units::second_t expectedDuration = 30_min)
+    {
+        _recordingPath = std::move(path);
+        _recordingDuration = expectedDuration;
+    }
+
+    /**
+     * Logs the telemetry samples recorded by the robot loop to
+     * the given file. See Telemetry for the format.
+     */
+    void SetTelemetryFile(std::string path)
+    {
+        _telemetryPath = std::move(path);
+    }
+
+    /**
+     * Dumps the trace spans of the last cycles of the robot
+     * loop to <prefix>-<n>.json after each loop overrun, and on
+     * DumpTrace(). RobotBase traces each phase of the loop, and
+     * robot code can add its own spans with TRACE_SPAN().
+     */
+    void SetTraceFile(std::string prefix)
+    {
+        _tracePath = std::move(prefix);
+    }
+
+    /**
+     * Dumps the trace spans of the last cycles, if a trace file
+     * was set. This may be called from any thread.
+     */
+    void DumpTrace() { _tracer.RequestDump(); }
+
+    /**
+     * Checks that the periodic functions, the command scheduler
+     * and the added periodic callbacks never allocate from the
+     * heap, and optionally never block the loop thread. Each new
+     * call site is reported through the telemetry, or the program
+     * aborts on the first one, and a report is printed when the
+     * loop stops. See HotPathGuard; this needs a build with the
+     * ROBOT_HOT_PATH_GUARD CMake option.
+     *
+     * A simulation or replay returns 1 if the guard was violated.
+     */
+    void SetHotPathGuard(HotPathGuard::Mode mode, bool checkBlocking = false)
+    {
+        _hotPathMode = mode;
+        _checkBlocking = checkBlocking;
+    }
+
+    /**
+     * Returns the number of guarded calls and violations of the
+     * hot path guard. This may be called from any thread.
+     */
+    HotPathGuard::Stats GetHotPathStats() const { return _hotPathGuard.GetStats(); }
+
+    /**
+     * Publishes the state of the robot loop to the shared-memory
+     * segment with the given name, such as SharedState::kDefaultName,
+     * for local tools like StateReader. RobotBase publishes the
+     * loop timing, and robot code can add its own entries.
+     */
+    void SetSharedStateName(std::string name)
+    {
+        _sharedStateName = std::move(name);
+    }
+
+    /**
+     * Returns the shared state of the robot loop. Add entries
+     * from RobotInit() and publish values from the robot loop
+     * thread only; values are stamped with GetCycleTime().
+     * Entries are invalid unless a shared state name was set.
+     */
+    SharedStatePublisher &GetSharedState() { return _sharedState; }
+
+#if ROBOT_COMMANDS
+    /**
+     * Returns the scheduler of the robot's commands, which is
+     * ticked every cycle right after RobotPeriodic(). Commands
+     * that do not run when disabled are canceled on disable.
+     */
+    CommandScheduler &GetCommandScheduler() { return _commands; }
+#endif
+
+    /**
+     * Returns the telemetry of the robot loop. Record samples
+     * and print messages through it from the robot loop thread
+     * only; it never blocks the loop on the console or disk.
+     * Samples are stamped with GetCycleTime().
+     */
+    Telemetry &GetTelemetry() { return _telemetry; }
+
+    /**
+     * Returns the time of the current cycle since the robot
+     * loop started. This is the recorded time during replay,
+     * so use it instead of the clock for repeatable behavior.
+     */
+    units::second_t GetCycleTime() const
+    {
+        return units::second_t{std::chrono::duration<double>(_cycleTime).count()};
+    }
+
+    /**
+     * Returns whether the robot program is replaying a recording.
+     */
+    bool IsReplaying() const { return _replaying; }
+
+    /**
+     * Returns whether the robot program is running a simulation.
+     */
+    bool IsSimulation() const { return _simulating; }
+
+    /**
+     * Returns the state read by the given logged input, in the
+     * order of AddLoggedInput(), during simulation. Set it from
+     * SimulationPeriodic(), such as with an InputScript.
+     */
+    InputState &GetSimulatedInput(size_t index)
+    {
+        return _externalInputs[index];
+    }
+
+    /**
+     * Sets the clock that schedules the robot loop.
+     * This must be called before Run().
+     */
+    void SetClock(LoopClock &clock)
+    {
+        _clock = &clock;
+    }
+
+    /**
+     * Adds a callback that runs on the robot loop thread every
+     * period, starting at the given offset from the first robot
+     * loop. Give slow callbacks different offsets so they never
+     * land on the same tick as each other or the robot loop.
+     *
+     * This must be called before Run() or from the robot loop
+     * thread. Returns a handle for GetPeriodicStats().
+     */
+    size_t AddPeriodic(std::function<void()> callback, units::millisecond_t period, units::millisecond_t offset = 0_ms);
+
+    /**
+     * Returns the run count, overrun accounting and execution
+     * time of a callback added with AddPeriodic().
+     */
+    PeriodicScheduler::Stats GetPeriodicStats(size_t handle) const
+    {
+        return _periodic.GetStats(handle);
+    }
+
+    /**
+     * Returns statistics of the measured loop period.
+     * This may be called from any thread.
+     */
+    JitterStats GetJitterStats() const;
+
+    /**
+     * Returns a summary of the durations of the given loop
+     * phase. This may be called from any thread.
+     */
+    LatencyHistogram::Summary GetLoopStats(LoopPhase phase) const
+    {
+        return _phaseStats[(size_t)phase].GetSummary();
+    }
+
+    /**
+     * Prints a table of the durations of every loop phase.
+     * This may be called from any thread.
+     */
+    void PrintLoopStats(FILE *file = stdout) const;
+
+    /**
+     * Returns the name of the given loop phase.
+     */
+    static char const *GetLoopPhaseName(LoopPhase phase);
+
     /**
      * Runs the robot program.
      */
     int Run();
 
+    /**
+     * Runs the robot program through a file written by
+     * SetRecordingFile() as fast as possible, feeding each
+     * cycle its recorded inputs and time without enabling the
+     * devices. Returns 0 if every cycle made the same IsEnabled()
+     * decision as the recording, or 1 otherwise.
+     */
+    int Replay(char const *path);
+
+    /**
+     * Runs the robot program for the given duration of
+     * simulated time, as fast as possible: the loop runs on a
+     * SimulatedClock, and SimulationPeriodic() steps physics
+     * and sets the inputs before every cycle. Prints the loop
+     * statistics, which measure the real cost of each phase.
+     */
+    int RunSimulation(units::second_t duration);
+
 private:
     static constexpr auto kErrorTimeMs = 500;
     std::chrono::time_point<std::chrono::steady_clock> _lastErrorTime = std::chrono::steady_clock::now();
 
+    std::array<LatencyHistogram, kNumLoopPhases> _phaseStats{};
+    /* phase durations of the current cycle, for the overrun report */
+    std::array<std::chrono::nanoseconds, kNumLoopPhases> _cyclePhases{};
+    std::atomic<uint64_t> _overruns{0};
+    std::atomic<uint64_t> _skipped{0};
+    std::atomic<uint64_t> _signalTimeouts{0};
+
     /** Reports a loop overrun with debouncing. */
     void ReportLoopOverrun(units::millisecond_t measured);
+    /** Records the duration of a loop phase. */
+    void RecordPhase(LoopPhase phase, std::chrono::nanoseconds duration)
+    {
+        _phaseStats[(size_t)phase].Record(duration);
+        _cyclePhases[(size_t)phase] = duration;
+    }
+    /** Records the measured start-to-start period of a cycle. */
+    void RecordPeriod(std::chrono::nanoseconds period);
+    /** Starts checking the robot loop thread with the hot path guard, if requested. */
+    void StartHotPathGuard();
+    /** Reports the new violations of the hot path guard. */
+    void ReportHotPathViolations();
+    /** Stops the hot path guard, printing its report. Returns false if it was violated. */
+    bool StopHotPathGuard();
+    /** Starts the recording, if one was requested. */
+    void StartRecording();
+    /** Runs one iteration of the robot periodic functions. */
+    void RunCycle();
 };
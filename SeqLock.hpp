@@ -0,0 +1,105 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <type_traits>
+#include <stdint.h>
+
+/**
+ * Publishes a trivially copyable value from one writer thread
+ * to any number of reader threads without locks.
+ *
+ * The writer never waits. A reader copies the value and
+ * retries if the writer published during the copy, so reads
+ * are consistent and take only a few nanoseconds when there
+ * is no contention. The value is stored as relaxed atomic
+ * words, so concurrent copies are well-defined.
+ */
+template <typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable_v<T>, "SeqLock values must be trivially copyable");
+
+private:
+    static constexpr size_t kWords = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    std::atomic<uint32_t> _seq{0};
+    std::array<std::atomic<uint64_t>, kWords> _words{};
+
+public:
+    SeqLock() { Store(T{}); }
+    explicit SeqLock(T const &value) { Store(value); }
+
+    SeqLock(SeqLock const &) = delete;
+    SeqLock &operator=(SeqLock const &) = delete;
+
+    /**
+     * Publishes a new value. Only one thread may store into a
+     * given SeqLock.
+     */
+    void Store(T const &value)
+    {
+        uint64_t words[kWords]{};
+        std::memcpy(words, &value, sizeof(T));
+
+        /* an odd sequence number tells readers a store is in progress */
+        uint32_t const seq = _seq.load(std::memory_order_relaxed);
+        _seq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        for (size_t i = 0; i < kWords; ++i) {
+            _words[i].store(words[i], std::memory_order_relaxed);
+        }
+
+        _seq.store(seq + 2, std::memory_order_release);
+    }
+
+    /**
+     * Copies out the latest value, retrying until the copy is
+     * consistent.
+     */
+    void Load(T &value) const
+    {
+        while (!TryLoad(value)) {}
+    }
+
+    /**
+     * Returns the latest value.
+     */
+    T Load() const
+    {
+        T value;
+        Load(value);
+        return value;
+    }
+
+    /**
+     * Attempts to copy out the latest value, returning false
+     * if a store was in progress.
+     */
+    bool TryLoad(T &value) const
+    {
+        uint32_t const seq = _seq.load(std::memory_order_acquire);
+        if (seq & 1) return false;
+
+        uint64_t words[kWords];
+        for (size_t i = 0; i < kWords; ++i) {
+            words[i] = _words[i].load(std::memory_order_relaxed);
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (_seq.load(std::memory_order_relaxed) != seq) return false;
+
+        std::memcpy(&value, words, sizeof(T));
+        return true;
+    }
+
+    /**
+     * Returns the number of values stored so far,
+     * including the initial value.
+     */
+    uint32_t GetVersion() const
+    {
+        return _seq.load(std::memory_order_acquire) / 2;
+    }
+};
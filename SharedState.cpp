@@ -0,0 +1,148 @@
+#include "SharedState.hpp"
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <new>
+
+bool SharedStatePublisher::Open(char const *name)
+{
+    Close();
+
+    if (strlen(name) >= sizeof(_name)) {
+        fprintf(stderr, "Error: Shared state name %s is too long\n", name);
+        return false;
+    }
+
+    /* always start from a new segment, so readers of a previous run never see it change under them */
+    shm_unlink(name);
+    int const fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        fprintf(stderr, "Error: Could not create shared state %s: %s\n", name, strerror(errno));
+        return false;
+    }
+    if (ftruncate(fd, sizeof(SharedState::Segment)) != 0) {
+        fprintf(stderr, "Error: Could not size shared state %s: %s\n", name, strerror(errno));
+        close(fd);
+        shm_unlink(name);
+        return false;
+    }
+    void *map = mmap(nullptr, sizeof(SharedState::Segment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "Error: Could not map shared state %s: %s\n", name, strerror(errno));
+        shm_unlink(name);
+        return false;
+    }
+
+    /* constructing the segment touches every page, so publishing never faults in the loop */
+    _segment = new (map) SharedState::Segment();
+    auto &header = _segment->header;
+    memcpy(header.magic, SharedState::kMagic, sizeof(header.magic));
+    header.maxEntries = SharedState::kMaxEntries;
+    header.pid = getpid();
+    header.version.store(SharedState::kVersion, std::memory_order_release);
+
+    strcpy(_name, name);
+    _numEntries = 0;
+    return true;
+}
+
+void SharedStatePublisher::Close()
+{
+    if (_segment == nullptr) return;
+
+    munmap(_segment, sizeof(SharedState::Segment));
+    shm_unlink(_name);
+    _segment = nullptr;
+    _numEntries = 0;
+}
+
+SharedStatePublisher::Entry SharedStatePublisher::AddEntry(char const *name, SharedState::Type type)
+{
+    if (_segment == nullptr) return kInvalidEntry;
+    if (_numEntries >= SharedState::kMaxEntries) {
+        fprintf(stderr, "Warning: Only %zu shared state entries are supported, ignoring %s\n", SharedState::kMaxEntries, name);
+        return kInvalidEntry;
+    }
+
+    auto &entry = _segment->entries[_numEntries];
+    snprintf(entry.name, sizeof(entry.name), "%s", name);
+    entry.type = type;
+    _types[_numEntries] = type;
+
+    /* readers only look at the entry once it is counted */
+    ++_numEntries;
+    _segment->header.numEntries.store(_numEntries, std::memory_order_release);
+    return _numEntries - 1;
+}
+
+bool SharedStateReader::Open(char const *name, bool printErrors)
+{
+    Close();
+
+    int const fd = shm_open(name, O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0) {
+        if (printErrors) fprintf(stderr, "Error: Could not open shared state %s: %s\n", name, strerror(errno));
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(SharedState::Segment)) {
+        if (printErrors) fprintf(stderr, "Error: %s is not a valid shared state segment\n", name);
+        close(fd);
+        return false;
+    }
+    void *map = mmap(nullptr, sizeof(SharedState::Segment), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        if (printErrors) fprintf(stderr, "Error: Could not map shared state %s: %s\n", name, strerror(errno));
+        return false;
+    }
+
+    auto const *segment = static_cast<SharedState::Segment const *>(map);
+    auto const &header = segment->header;
+    if (header.version.load(std::memory_order_acquire) != SharedState::kVersion ||
+        memcmp(header.magic, SharedState::kMagic, sizeof(header.magic)) != 0 ||
+        header.maxEntries != SharedState::kMaxEntries)
+    {
+        if (printErrors) fprintf(stderr, "Error: %s is not a valid shared state segment\n", name);
+        munmap(map, sizeof(SharedState::Segment));
+        return false;
+    }
+
+    _segment = segment;
+    return true;
+}
+
+void SharedStateReader::Close()
+{
+    if (_segment == nullptr) return;
+
+    munmap(const_cast<SharedState::Segment *>(_segment), sizeof(SharedState::Segment));
+    _segment = nullptr;
+}
+
+bool SharedStateReader::IsPublisherAlive() const
+{
+    /* the publisher may belong to another user, which still means it is alive */
+    return kill((pid_t)_segment->header.pid, 0) == 0 || errno == EPERM;
+}
+
+size_t SharedStateReader::GetNumEntries() const
+{
+    size_t const count = _segment->header.numEntries.load(std::memory_order_acquire);
+    return count < SharedState::kMaxEntries ? count : SharedState::kMaxEntries;
+}
+
+bool SharedStateReader::Read(size_t index, SharedState::Sample &sample) const
+{
+    /* a store takes nanoseconds, so a store that never finishes means the publisher died in it */
+    for (int attempt = 0; attempt < 1000; ++attempt) {
+        if (_segment->entries[index].sample.TryLoad(sample)) return true;
+    }
+    return false;
+}
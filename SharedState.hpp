@@ -0,0 +1,221 @@
+#pragma once
+
+#include "SeqLock.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <type_traits>
+#include <stdint.h>
+
+/**
+ * A table of named, typed values in a shared-memory segment,
+ * published by the robot loop and sampled by any number of
+ * local processes, such as dashboards and health monitors.
+ *
+ * Each entry has its own SeqLock, so publishing a value is a
+ * single lock-free store into the mapping, and readers copy it
+ * without syscalls or any effect on the publisher. The segment
+ * holds a Header followed by kMaxEntries Entry slots; entries
+ * are only ever appended, and their names never change.
+ */
+namespace SharedState {
+
+static constexpr size_t kMaxEntries = 256;
+static constexpr size_t kMaxNameLength = 48;
+
+static constexpr char kMagic[8] = {'P', '6', 'S', 'T', 'A', 'T', 'E', '\0'};
+static constexpr uint32_t kVersion = 1;
+
+/** The segment published by the robot program by default */
+static constexpr char const *kDefaultName = "/phoenix6-robot";
+
+enum class Type : uint32_t {
+    Double,
+    Int64,
+    Bool,
+};
+
+/**
+ * One published value, stamped with the robot loop's cycle time.
+ */
+struct Sample {
+    int64_t timestampNs;
+    union {
+        /** The value of a Double entry */
+        double number;
+        /** The value of an Int64 or Bool entry */
+        int64_t integer;
+    };
+};
+
+struct Entry {
+    char name[kMaxNameLength];
+    Type type;
+    uint32_t reserved;
+    SeqLock<Sample> sample;
+};
+
+struct Header {
+    char magic[8];
+    /** Stored last by the publisher, so a valid version means the header is complete */
+    std::atomic<uint32_t> version;
+    uint32_t maxEntries;
+    /** The process ID of the publisher */
+    int64_t pid;
+    /** Entries are complete before they are counted */
+    std::atomic<uint32_t> numEntries;
+    uint32_t reserved;
+};
+
+struct Segment {
+    Header header;
+    std::array<Entry, kMaxEntries> entries;
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free,
+              "shared-memory atomics must be lock-free to work across processes");
+
+}
+
+/**
+ * Publishes values into a SharedState segment. Only one thread
+ * may add entries and publish values, such as the robot loop.
+ */
+class SharedStatePublisher {
+public:
+    using Entry = uint16_t;
+    static constexpr Entry kInvalidEntry = 0xFFFF;
+
+private:
+    SharedState::Segment *_segment = nullptr;
+    char _name[64]{};
+    /* the types of the entries, so publishing never reads the mapping */
+    std::array<SharedState::Type, SharedState::kMaxEntries> _types{};
+    size_t _numEntries = 0;
+    int64_t _timestampNs = 0;
+
+public:
+    SharedStatePublisher() = default;
+    ~SharedStatePublisher() { Close(); }
+
+    SharedStatePublisher(SharedStatePublisher const &) = delete;
+    SharedStatePublisher &operator=(SharedStatePublisher const &) = delete;
+
+    /**
+     * Creates the segment with the given name, such as
+     * SharedState::kDefaultName, replacing any existing one.
+     * Returns false and prints the error on failure.
+     */
+    bool Open(char const *name);
+
+    /**
+     * Unmaps and removes the segment. Readers that still have
+     * it mapped keep the last published values.
+     */
+    void Close();
+
+    /**
+     * Returns whether a segment is open.
+     */
+    bool IsOpen() const { return _segment != nullptr; }
+
+    /**
+     * Adds an entry with the given name and type, returning
+     * kInvalidEntry if no segment is open or the table is full.
+     */
+    Entry AddEntry(char const *name, SharedState::Type type);
+
+    /**
+     * Sets the timestamp of the following values, such as the
+     * time of the current robot loop cycle.
+     */
+    void SetTime(std::chrono::nanoseconds timestamp)
+    {
+        _timestampNs = timestamp.count();
+    }
+
+    /**
+     * Publishes a value, converted to the type of the entry.
+     * Values published to kInvalidEntry are ignored.
+     */
+    template <typename T>
+    void Publish(Entry entry, T value)
+    {
+        static_assert(std::is_arithmetic_v<T>, "only numbers and bools can be published");
+        if (entry >= _numEntries) return;
+
+        SharedState::Sample sample{};
+        sample.timestampNs = _timestampNs;
+        if (_types[entry] == SharedState::Type::Double) {
+            sample.number = (double)value;
+        } else if (_types[entry] == SharedState::Type::Bool) {
+            sample.integer = value ? 1 : 0;
+        } else {
+            sample.integer = (int64_t)value;
+        }
+        _segment->entries[entry].sample.Store(sample);
+    }
+};
+
+/**
+ * Samples a SharedState segment through a read-only mapping.
+ */
+class SharedStateReader {
+    SharedState::Segment const *_segment = nullptr;
+
+public:
+    SharedStateReader() = default;
+    ~SharedStateReader() { Close(); }
+
+    SharedStateReader(SharedStateReader const &) = delete;
+    SharedStateReader &operator=(SharedStateReader const &) = delete;
+
+    /**
+     * Maps the segment with the given name. Returns false, and
+     * optionally prints the error, if it does not exist or is
+     * not valid.
+     */
+    bool Open(char const *name, bool printErrors = true);
+
+    /**
+     * Unmaps the segment.
+     */
+    void Close();
+
+    bool IsOpen() const { return _segment != nullptr; }
+
+    /**
+     * Returns whether the process that published the segment
+     * is still running.
+     */
+    bool IsPublisherAlive() const;
+
+    /**
+     * Returns the number of entries published so far,
+     * which only ever grows.
+     */
+    size_t GetNumEntries() const;
+
+    /**
+     * Returns the name of the given entry, which must be less
+     * than GetNumEntries().
+     */
+    char const *GetName(size_t index) const { return _segment->entries[index].name; }
+
+    /**
+     * Returns the type of the given entry, which must be less
+     * than GetNumEntries().
+     */
+    SharedState::Type GetType(size_t index) const { return _segment->entries[index].type; }
+
+    /**
+     * Returns the number of values published to the given entry.
+     */
+    uint32_t GetVersion(size_t index) const { return _segment->entries[index].sample.GetVersion(); }
+
+    /**
+     * Copies out the latest value of the given entry. Returns
+     * false if the publisher died in the middle of a store.
+     */
+    bool Read(size_t index, SharedState::Sample &sample) const;
+};
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+
+/**
+ * Adds to a counter that only one thread writes, and that any
+ * thread may read. With a single writer, a relaxed load and
+ * store avoids the cost of a locked read-modify-write, and
+ * readers still never see a torn value.
+ */
+inline void SingleWriterAdd(std::atomic<uint64_t> &counter, uint64_t value = 1)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <type_traits>
+#include <stddef.h>
+
+/**
+ * Fixed-capacity lock-free queue between exactly one producer
+ * thread and one consumer thread. Neither side ever blocks or
+ * allocates; a push into a full ring fails instead.
+ */
+template <typename T, size_t Capacity>
+class SpscRing {
+    static_assert(std::is_trivially_copyable_v<T>, "SpscRing values must be trivially copyable");
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "SpscRing capacity must be a power of two");
+
+private:
+    static constexpr size_t kMask = Capacity - 1;
+
+    /* the indices only ever increase, and each lives on its own cache line */
+    alignas(64) std::atomic<size_t> _head{0};
+    alignas(64) std::atomic<size_t> _tail{0};
+    alignas(64) std::array<T, Capacity> _items{};
+
+public:
+    /**
+     * Adds a value, returning false if the ring is full.
+     * Only the producer thread may push.
+     */
+    bool TryPush(T const &value)
+    {
+        size_t const tail = _tail.load(std::memory_order_relaxed);
+        if (tail - _head.load(std::memory_order_acquire) >= Capacity) return false;
+
+        _items[tail & kMask] = value;
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Removes the oldest value, returning false if the ring
+     * is empty. Only the consumer thread may pop.
+     */
+    bool TryPop(T &value)
+    {
+        size_t const head = _head.load(std::memory_order_relaxed);
+        if (head == _tail.load(std::memory_order_acquire)) return false;
+
+        value = _items[head & kMask];
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Returns the capacity of the ring.
+     */
+    static constexpr size_t GetCapacity() { return Capacity; }
+};
@@ -0,0 +1,104 @@
+#include "SharedState.hpp"
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+
+namespace {
+
+/**
+ * Prints every entry whose name starts with the filter.
+ */
+void PrintEntries(SharedStateReader const &reader, char const *filter)
+{
+    printf("%-32s %-6s %16s %10s %10s\n", "entry", "type", "value", "time (s)", "updates");
+
+    size_t const numEntries = reader.GetNumEntries();
+    for (size_t i = 0; i < numEntries; ++i) {
+        char const *const name = reader.GetName(i);
+        if (strncmp(name, filter, strlen(filter)) != 0) continue;
+
+        SharedState::Sample sample;
+        if (!reader.Read(i, sample)) {
+            printf("%-32s (torn)\n", name);
+            continue;
+        }
+        uint32_t const updates = reader.GetVersion(i) - 1;
+        switch (reader.GetType(i)) {
+        case SharedState::Type::Double:
+            printf("%-32s %-6s %16.4f", name, "double", sample.number);
+            break;
+        case SharedState::Type::Int64:
+            printf("%-32s %-6s %16" PRId64, name, "int64", sample.integer);
+            break;
+        case SharedState::Type::Bool:
+            printf("%-32s %-6s %16s", name, "bool", sample.integer ? "true" : "false");
+            break;
+        default:
+            printf("%-32s %-6s %16s", name, "?", "");
+            break;
+        }
+        printf(" %10.3f %10" PRIu32 "\n", sample.timestampNs / 1e9, updates);
+    }
+}
+
+}
+
+/**
+ * Prints the state published by a running robot program
+ * through shared memory, without affecting its loop.
+ *
+ * Usage: ./StateReader [--name <segment>] [--watch <hz>] [prefix]
+ */
+int main(int argc, char **argv)
+{
+    char const *name = SharedState::kDefaultName;
+    double watchHz = 0;
+    char const *filter = "";
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--name") == 0 && i + 1 < argc) {
+            name = argv[++i];
+        } else if (strcmp(argv[i], "--watch") == 0 && i + 1 < argc) {
+            watchHz = atof(argv[++i]);
+        } else if (argv[i][0] != '-') {
+            filter = argv[i];
+        } else {
+            fprintf(stderr, "Usage: %s [--name <segment>] [--watch <hz>] [prefix]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    SharedStateReader readers[2];
+    if (!readers[0].Open(name)) return 1;
+
+    if (watchHz <= 0) {
+        PrintEntries(readers[0], filter);
+        return 0;
+    }
+
+    /* keeps showing the last values of a stopped robot program until it restarts */
+    size_t current = 0;
+
+    auto const period = std::chrono::duration<double>{1.0 / watchHz};
+    auto wake = std::chrono::steady_clock::now();
+    while (true) {
+        /* clear the terminal and redraw from the top */
+        printf("\033[H\033[J%s", name);
+        if (!readers[current].IsPublisherAlive()) {
+            /* a restarted robot program publishes a new segment under the same name */
+            SharedStateReader &restarted = readers[1 - current];
+            if (restarted.Open(name, false) && restarted.IsPublisherAlive()) {
+                readers[current].Close();
+                current = 1 - current;
+            }
+        }
+        printf(readers[current].IsPublisherAlive() ? "\n" : " (stopped)\n");
+        PrintEntries(readers[current], filter);
+        fflush(stdout);
+
+        wake += std::chrono::duration_cast<std::chrono::steady_clock::duration>(period);
+        std::this_thread::sleep_until(wake);
+    }
+}
@@ -0,0 +1,155 @@
+#pragma once
+
+#include "DeviceRegistry.hpp"
+#include <array>
+#include <string>
+#include <vector>
+
+/**
+ * A group of TalonFXs in a DeviceRegistry, named at compile time
+ * by a list of CAN IDs, such as TalonFXTable<0, 2> for the leaders
+ * of a drivetrain. Operations over the whole group are fold
+ * expressions over the ID list, so they unroll into one call per
+ * device with its handle at a constant index, instead of a loop
+ * or a line of copy-paste per device.
+ *
+ * The devices' signals join the batched refresh of their bus,
+ * their configurations are applied together by ApplyConfigs(),
+ * and their control requests are sent by SendControls() of the
+ * registry.
+ */
+template <int... Ids>
+class TalonFXTable {
+public:
+    static constexpr size_t kSize = sizeof...(Ids);
+    static constexpr std::array<int, kSize> kIds{Ids...};
+
+private:
+    static_assert(kSize > 0, "a device table needs at least one device");
+
+    static constexpr bool HasUniqueIds()
+    {
+        for (size_t i = 0; i < kSize; ++i) {
+            for (size_t j = i + 1; j < kSize; ++j) {
+                if (kIds[i] == kIds[j]) return false;
+            }
+        }
+        return true;
+    }
+
+    template <int Id>
+    static constexpr size_t IndexOf()
+    {
+        size_t index = 0;
+        while (index < kSize && kIds[index] != Id) {
+            ++index;
+        }
+        return index;
+    }
+
+    DeviceRegistry &_registry;
+    std::array<DeviceRegistry::Handle, kSize> const _handles;
+
+public:
+    /**
+     * Adds the devices to the registry on the given bus, in the
+     * order of the ID list.
+     */
+    TalonFXTable(DeviceRegistry &registry, std::string const &canbus) :
+        _registry{registry},
+        _handles{registry.AddTalonFX(Ids, canbus)...}
+    {
+        static_assert(HasUniqueIds(), "each device may only be in a table once");
+    }
+
+    TalonFXTable(TalonFXTable const &) = delete;
+    TalonFXTable &operator=(TalonFXTable const &) = delete;
+
+    /**
+     * Returns the registry handle of the device with the given ID.
+     */
+    template <int Id>
+    DeviceRegistry::Handle GetHandle() const
+    {
+        static_assert(IndexOf<Id>() < kSize, "the device is not in this table");
+        return _handles[IndexOf<Id>()];
+    }
+
+    /**
+     * Returns the device with the given ID.
+     */
+    template <int Id>
+    ctre::phoenix6::hardware::TalonFX &Get() const
+    {
+        return _registry.Get(GetHandle<Id>());
+    }
+
+    /**
+     * Calls func(id, device) for every device, in order.
+     */
+    template <typename Func>
+    void ForEach(Func &&func) const
+    {
+        (func(Ids, Get<Ids>()), ...);
+    }
+
+    /**
+     * Adds the signals returned by getSignals(device) as a
+     * vector of BaseStatusSignal pointers, for every device.
+     * The registry refreshes them with the rest of their bus in
+     * a single batched call. See DeviceRegistry::AddSignals().
+     */
+    template <typename Func>
+    void AddSignals(Func &&getSignals)
+    {
+        (_registry.AddSignals(GetHandle<Ids>(), getSignals(Get<Ids>())), ...);
+    }
+
+    /**
+     * Gives every device the same configuration for ApplyConfigs().
+     */
+    void SetConfig(ctre::phoenix6::configs::TalonFXConfiguration const &config)
+    {
+        (_registry.SetConfig(GetHandle<Ids>(), config), ...);
+    }
+
+    /**
+     * Gives each device its own configuration for ApplyConfigs(),
+     * in the order of the ID list.
+     */
+    template <typename... Configs>
+    void SetConfigs(Configs const &... configs)
+    {
+        static_assert(sizeof...(Configs) == kSize, "give one configuration per device");
+        (_registry.SetConfig(GetHandle<Ids>(), configs), ...);
+    }
+
+    /**
+     * Sets the control request of the device with the given ID.
+     */
+    template <int Id, typename Request>
+    void SetControl(Request const &request)
+    {
+        _registry.SetControl(GetHandle<Id>(), request);
+    }
+
+    /**
+     * Sets the same control request for every device.
+     */
+    template <typename Request>
+    void SetControl(Request const &request)
+    {
+        (_registry.SetControl(GetHandle<Ids>(), request), ...);
+    }
+
+    /**
+     * Sets the control request of each device, in the order of
+     * the ID list. The requests may be of different types.
+     */
+    template <typename... Requests>
+    void SetControls(Requests const &... requests)
+    {
+        static_assert(sizeof...(Requests) == kSize, "give one control request per device");
+        (_registry.SetControl(GetHandle<Ids>(), requests), ...);
+    }
+};
@@ -0,0 +1,150 @@
+#include "Telemetry.hpp"
+#include <errno.h>
+#include <stdarg.h>
+#include <string.h>
+#include <vector>
+
+void Telemetry::Start(std::string path)
+{
+    Stop();
+
+    _path = std::move(path);
+    _running.store(true, std::memory_order_relaxed);
+    _writer = std::thread{[this] { WriterThread(); }};
+}
+
+void Telemetry::Stop()
+{
+    if (_writer.joinable()) {
+        _running.store(false, std::memory_order_relaxed);
+        _writer.join();
+    }
+}
+
+Telemetry::Channel Telemetry::AddChannel(char const *name)
+{
+    if (_numChannels >= kMaxChannels) {
+        Print(stderr, "Warning: Too many telemetry channels, ignoring %s\n", name);
+        return kInvalidChannel;
+    }
+
+    auto &dest = _names[_numChannels];
+    strncpy(dest.data(), name, dest.size() - 1);
+    return _numChannels++;
+}
+
+void Telemetry::Print(FILE *stream, char const *format, ...)
+{
+    Message message;
+    message.stream = stream;
+
+    va_list args;
+    va_start(args, format);
+    vsnprintf(message.text, sizeof(message.text), format, args);
+    va_end(args);
+
+    if (!_messages.TryPush(message)) {
+        CountDropped();
+    }
+}
+
+void Telemetry::WriterThread()
+{
+    FILE *file = nullptr;
+    if (!_path.empty()) {
+        file = fopen(_path.c_str(), "wb");
+        if (file == nullptr) {
+            fprintf(stderr, "Error: Could not create telemetry log %s: %s\n", _path.c_str(), strerror(errno));
+        } else {
+            fwrite(kMagic, sizeof(kMagic), 1, file);
+            fwrite(&kVersion, sizeof(kVersion), 1, file);
+        }
+    }
+
+    /* columns of the current batch, and which channels the file has named */
+    std::vector<std::vector<int64_t>> timestamps(kMaxChannels);
+    std::vector<std::vector<double>> values(kMaxChannels);
+    std::vector<bool> named(kMaxChannels, false);
+    uint64_t loggedDropped = 0;
+    int64_t lastTimestampNs = 0;
+
+    bool running = true;
+    while (running) {
+        /* read the flag first, so the final pass drains everything queued before Stop() */
+        running = _running.load(std::memory_order_relaxed);
+        auto const wakeTime = std::chrono::steady_clock::now() + kWritePeriod;
+
+        Message message;
+        bool printed = false;
+        while (_messages.TryPop(message)) {
+            fputs(message.text, message.stream);
+            printed = true;
+        }
+        if (printed) {
+            fflush(stdout);
+            fflush(stderr);
+        }
+
+        /* split the batch into per-channel columns */
+        Sample sample;
+        bool sampled = false;
+        while (_samples.TryPop(sample)) {
+            timestamps[sample.channel].push_back(sample.timestampNs);
+            values[sample.channel].push_back(sample.value);
+            lastTimestampNs = sample.timestampNs;
+            sampled = true;
+        }
+
+        if (file != nullptr && sampled) {
+            for (size_t channel = 0; channel < kMaxChannels; ++channel) {
+                auto const count = timestamps[channel].size();
+                if (count == 0) continue;
+
+                if (!named[channel]) {
+                    /* the name was written before the channel's first sample was pushed */
+                    auto const &name = _names[channel];
+                    BlockHeader const header{(Channel)channel, BlockType::ChannelName, (uint32_t)strnlen(name.data(), name.size())};
+                    fwrite(&header, sizeof(header), 1, file);
+                    fwrite(name.data(), 1, header.count, file);
+                    named[channel] = true;
+                }
+
+                BlockHeader const header{(Channel)channel, BlockType::Data, (uint32_t)count};
+                fwrite(&header, sizeof(header), 1, file);
+                fwrite(timestamps[channel].data(), sizeof(int64_t), count, file);
+                fwrite(values[channel].data(), sizeof(double), count, file);
+
+                timestamps[channel].clear();
+                values[channel].clear();
+            }
+        } else if (sampled) {
+            for (size_t channel = 0; channel < kMaxChannels; ++channel) {
+                timestamps[channel].clear();
+                values[channel].clear();
+            }
+        }
+
+        uint64_t const dropped = GetDropped();
+        if (file != nullptr && dropped != loggedDropped) {
+            /* stamped with the latest sample, on the same timeline as the data */
+            BlockHeader const header{kInvalidChannel, BlockType::Dropped, 1};
+            double const value = dropped;
+            fwrite(&header, sizeof(header), 1, file);
+            fwrite(&lastTimestampNs, sizeof(lastTimestampNs), 1, file);
+            fwrite(&value, sizeof(value), 1, file);
+            loggedDropped = dropped;
+        }
+
+        if (file != nullptr && sampled) {
+            fflush(file);
+        }
+
+        if (running) {
+            std::this_thread::sleep_until(wakeTime);
+        }
+    }
+
+    if (file != nullptr) {
+        fclose(file);
+    }
+}
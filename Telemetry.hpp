@@ -0,0 +1,151 @@
+#pragma once
+
+#include "SingleWriter.hpp"
+#include "SpscRing.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * Structured telemetry and console messages for the robot
+ * loop. The loop thread writes samples and messages into
+ * lock-free rings without allocating or blocking, and a
+ * background writer thread prints the messages and batches
+ * the samples into a columnar binary log file.
+ *
+ * When a ring is full, the record is dropped and counted;
+ * the writer logs the total dropped count to the file.
+ *
+ * The log file starts with kMagic and kVersion, followed by
+ * blocks that each begin with a BlockHeader:
+ *  - Data: count timestamps (int64 ns), then count values (double)
+ *  - ChannelName: count bytes of the channel's name
+ *  - Dropped: one timestamp and the total dropped count (double)
+ */
+class Telemetry {
+public:
+    using Channel = uint16_t;
+    static constexpr Channel kInvalidChannel = 0xFFFF;
+    static constexpr size_t kMaxChannels = 256;
+    static constexpr size_t kMaxNameLength = 32;
+    static constexpr size_t kMaxMessageLength = 120;
+
+    static constexpr char kMagic[8] = {'P', '6', 'T', 'E', 'L', 'E', 'M', '\0'};
+    static constexpr uint32_t kVersion = 1;
+
+    enum class BlockType : uint16_t {
+        Data,
+        ChannelName,
+        Dropped,
+    };
+
+    struct BlockHeader {
+        /** The channel of the block, or kInvalidChannel for Dropped */
+        Channel channel;
+        BlockType type;
+        uint32_t count;
+    };
+
+private:
+    struct Sample {
+        int64_t timestampNs;
+        double value;
+        Channel channel;
+    };
+
+    struct Message {
+        FILE *stream;
+        char text[kMaxMessageLength];
+    };
+
+    static constexpr auto kWritePeriod = std::chrono::milliseconds{10};
+
+    SpscRing<Sample, 8192> _samples{};
+    SpscRing<Message, 64> _messages{};
+    std::atomic<uint64_t> _dropped{0};
+
+    /* written only by the producer, and only before the channel is first recorded */
+    std::array<std::array<char, kMaxNameLength>, kMaxChannels> _names{};
+    size_t _numChannels = 0;
+
+    int64_t _timestampNs = 0;
+
+    std::string _path;
+    std::thread _writer;
+    std::atomic<bool> _running{false};
+
+public:
+    Telemetry() = default;
+    ~Telemetry() { Stop(); }
+
+    Telemetry(Telemetry const &) = delete;
+    Telemetry &operator=(Telemetry const &) = delete;
+
+    /**
+     * Starts the writer thread, logging samples to the given
+     * file, or only printing messages if the path is empty.
+     */
+    void Start(std::string path);
+
+    /**
+     * Writes out everything queued and stops the writer thread.
+     */
+    void Stop();
+
+    /**
+     * Adds a channel of samples with the given name, returning
+     * kInvalidChannel if there are too many channels.
+     * This must be called from the producer thread.
+     */
+    Channel AddChannel(char const *name);
+
+    /**
+     * Sets the timestamp of the following samples, such as the
+     * time of the current robot loop cycle.
+     */
+    void SetTime(std::chrono::nanoseconds timestamp)
+    {
+        _timestampNs = timestamp.count();
+    }
+
+    /**
+     * Records a sample on a channel. Only one thread may
+     * record samples and messages.
+     */
+    void Record(Channel channel, double value)
+    {
+        if (channel >= _numChannels) return;
+        if (!_samples.TryPush(Sample{_timestampNs, value, channel})) {
+            CountDropped();
+        }
+    }
+
+    /**
+     * Formats a message that the writer thread prints to the
+     * given stream, truncated to kMaxMessageLength. This never
+     * allocates, so it may be called from the robot loop.
+     */
+    void Print(FILE *stream, char const *format, ...) __attribute__((format(printf, 3, 4)));
+
+    /**
+     * Returns the number of samples and messages dropped
+     * because a ring was full. This may be called from any thread.
+     */
+    uint64_t GetDropped() const
+    {
+        return _dropped.load(std::memory_order_relaxed);
+    }
+
+private:
+    void CountDropped()
+    {
+        /* only the producer writes the count */
+        SingleWriterAdd(_dropped);
+    }
+
+    void WriterThread();
+};
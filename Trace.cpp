@@ -0,0 +1,118 @@
+#include "Trace.hpp"
+#include <algorithm>
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+/*static*/ thread_local Tracer *Tracer::t_tracer = nullptr;
+
+#if ROBOT_TRACE
+
+namespace {
+
+/* writes a string as a JSON string literal, since span names can be any text */
+void WriteJsonString(FILE *file, char const *str)
+{
+    fputc('"', file);
+    for (unsigned char const *c = (unsigned char const *)str; *c != '\0'; ++c) {
+        if (*c == '"' || *c == '\\') {
+            fputc('\\', file);
+            fputc(*c, file);
+        } else if (*c < 0x20) {
+            fprintf(file, "\\u%04x", *c);
+        } else {
+            fputc(*c, file);
+        }
+    }
+    fputc('"', file);
+}
+
+}
+
+void Tracer::Start(std::string prefix, size_t numCycles, int maxDumps)
+{
+    Stop();
+
+    _path = std::move(prefix);
+    _numCycles = numCycles < 1 ? 1 : numCycles > kMaxCycles - 1 ? kMaxCycles - 1 : numCycles;
+    _maxDumps = maxDumps;
+    _dumps = 0;
+    _running.store(true, std::memory_order_relaxed);
+    _thread = std::thread{[this] { DumpThread(); }};
+}
+
+void Tracer::Stop()
+{
+    if (_thread.joinable()) {
+        _running.store(false, std::memory_order_relaxed);
+        _thread.join();
+    }
+}
+
+void Tracer::Freeze()
+{
+    if (_dumps >= _maxDumps) return;
+    ++_dumps;
+
+    /* dump from the start of the oldest cycle still in both rings */
+    uint64_t const cycles = _cycle < _numCycles ? _cycle : _numCycles;
+    uint64_t from = cycles > 0 ? _cycleStarts[(_cycle - cycles) % kMaxCycles] : _writeIndex;
+    if (_writeIndex - from > kMaxEvents) {
+        from = _writeIndex - kMaxEvents;
+    }
+    _dumpFrom = from;
+    _dumpTo = _writeIndex;
+
+    /* hands the ring to the dump thread until it unfreezes it */
+    _frozen.store(true, std::memory_order_release);
+}
+
+void Tracer::DumpThread()
+{
+    while (_running.load(std::memory_order_relaxed)) {
+        if (_frozen.load(std::memory_order_acquire)) {
+            char path[512];
+            snprintf(path, sizeof(path), "%s-%d.json", _path.c_str(), _dumps);
+            if (WriteDump(path)) {
+                printf("Wrote a trace of %" PRIu64 " spans to %s\n", _dumpTo - _dumpFrom, path);
+            }
+            _frozen.store(false, std::memory_order_release);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds{10});
+    }
+}
+
+bool Tracer::WriteDump(char const *path) const
+{
+    FILE *file = fopen(path, "w");
+    if (file == nullptr) {
+        fprintf(stderr, "Error: Could not create trace %s: %s\n", path, strerror(errno));
+        return false;
+    }
+
+    /* complete ("X") events in microseconds, relative to the earliest span;
+     * spans are recorded as they end, so an enclosing span comes after its children */
+    int64_t origin = INT64_MAX;
+    for (uint64_t i = _dumpFrom; i < _dumpTo; ++i) {
+        origin = std::min(origin, (*_events)[i % kMaxEvents].startNs);
+    }
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    for (uint64_t i = _dumpFrom; i < _dumpTo; ++i) {
+        auto const &event = (*_events)[i % kMaxEvents];
+        fprintf(file, "%s{\"name\":", i == _dumpFrom ? "" : ",");
+        WriteJsonString(file, event.name);
+        fprintf(file, ",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}\n",
+                (event.startNs - origin) / 1e3, (event.endNs - event.startNs) / 1e3);
+    }
+    fprintf(file, "]}\n");
+    fclose(file);
+    return true;
+}
+
+#else
+
+void Tracer::Start(std::string, size_t, int) {}
+void Tracer::Stop() {}
+
+#endif
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <stdint.h>
+
+/* set by the ROBOT_TRACING CMake option */
+#ifndef ROBOT_TRACE
+#define ROBOT_TRACE 0
+#endif
+
+/**
+ * Flight recorder of trace spans in the robot loop.
+ *
+ * Spans are recorded into an always-on ring holding the last
+ * cycles of the loop, without locks or allocations. When a dump
+ * is requested (by RobotBase on a loop overrun, or on demand
+ * from any thread), the ring is frozen at the next cycle and a
+ * background thread writes the last cycles as Chrome trace
+ * event JSON, which can be opened in Perfetto or chrome://tracing.
+ * New spans are dropped until the dump is written.
+ *
+ * Only the thread that calls SetThreadTracer() records spans;
+ * RobotBase does this for the robot loop thread. When built
+ * without ROBOT_TRACE, every span compiles to nothing.
+ */
+class Tracer {
+public:
+    static constexpr size_t kMaxEvents = 8192;
+    static constexpr size_t kMaxCycles = 64;
+
+private:
+    struct Event {
+        char const *name;
+        int64_t startNs;
+        int64_t endNs;
+    };
+
+#if ROBOT_TRACE
+    std::unique_ptr<std::array<Event, kMaxEvents>> _events = std::make_unique<std::array<Event, kMaxEvents>>();
+    std::array<uint64_t, kMaxCycles> _cycleStarts{};
+    /* written by the loop thread, read by the dump thread while frozen */
+    uint64_t _writeIndex = 0;
+    uint64_t _cycle = 0;
+
+    std::atomic<bool> _frozen{false};
+    std::atomic<bool> _dumpRequested{false};
+    uint64_t _dumpFrom = 0;
+    uint64_t _dumpTo = 0;
+
+    std::string _path;
+    size_t _numCycles = 50;
+    int _maxDumps = 10;
+    int _dumps = 0;
+
+    std::thread _thread;
+    std::atomic<bool> _running{false};
+#endif
+
+    static thread_local Tracer *t_tracer;
+
+public:
+    Tracer() = default;
+    ~Tracer() { Stop(); }
+
+    Tracer(Tracer const &) = delete;
+    Tracer &operator=(Tracer const &) = delete;
+
+    /**
+     * Returns the tracer of the calling thread, or nullptr.
+     */
+    static Tracer *GetThreadTracer() { return t_tracer; }
+
+    /**
+     * Records the spans of the calling thread into the given
+     * tracer, or stops recording them if nullptr.
+     */
+    static void SetThreadTracer(Tracer *tracer) { t_tracer = tracer; }
+
+    /**
+     * Starts the dump thread, writing each dump to
+     * <prefix>-<n>.json. At most maxDumps are written, so a
+     * robot that keeps overrunning does not fill the disk.
+     */
+    void Start(std::string prefix, size_t numCycles = 50, int maxDumps = 10);
+
+    /**
+     * Stops the dump thread.
+     */
+    void Stop();
+
+    /**
+     * Marks the start of a loop cycle. Call this from the
+     * recording thread.
+     */
+    void BeginCycle()
+    {
+#if ROBOT_TRACE
+        if (_frozen.load(std::memory_order_acquire)) {
+            /* the cycles asking for a dump are already being dumped */
+            _dumpRequested.store(false, std::memory_order_relaxed);
+            return;
+        }
+        if (_dumpRequested.exchange(false, std::memory_order_relaxed) && _running.load(std::memory_order_relaxed)) {
+            Freeze();
+            return;
+        }
+        _cycleStarts[_cycle % kMaxCycles] = _writeIndex;
+        ++_cycle;
+#endif
+    }
+
+    /**
+     * Records a span with the given name, which must be a
+     * string literal, between two times of the steady clock.
+     * Call this from the recording thread.
+     */
+    void Record(char const *name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+    {
+#if ROBOT_TRACE
+        if (_frozen.load(std::memory_order_relaxed)) return;
+        (*_events)[_writeIndex % kMaxEvents] = Event{
+            name,
+            start.time_since_epoch().count(),
+            end.time_since_epoch().count(),
+        };
+        ++_writeIndex;
+#else
+        (void)name;
+        (void)start;
+        (void)end;
+#endif
+    }
+
+    /**
+     * Dumps the last cycles at the start of the next cycle.
+     * This may be called from any thread.
+     */
+    void RequestDump()
+    {
+#if ROBOT_TRACE
+        _dumpRequested.store(true, std::memory_order_relaxed);
+#endif
+    }
+
+private:
+#if ROBOT_TRACE
+    void Freeze();
+    void DumpThread();
+    bool WriteDump(char const *path) const;
+#endif
+};
+
+/**
+ * Records a trace span from its construction to the end of its
+ * scope, on threads with a tracer. Use TRACE_SPAN("name").
+ */
+class TraceSpan {
+#if ROBOT_TRACE
+    Tracer *const _tracer = Tracer::GetThreadTracer();
+    char const *const _name;
+    std::chrono::steady_clock::time_point const _start = _tracer ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+
+public:
+    explicit TraceSpan(char const *name) : _name{name} {}
+    ~TraceSpan()
+    {
+        if (_tracer) _tracer->Record(_name, _start, std::chrono::steady_clock::now());
+    }
+#else
+public:
+    explicit constexpr TraceSpan(char const *) {}
+#endif
+
+    TraceSpan(TraceSpan const &) = delete;
+    TraceSpan &operator=(TraceSpan const &) = delete;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+/**
+ * Traces the rest of the enclosing scope as a span with the
+ * given name, which must be a string literal.
+ */
+#define TRACE_SPAN(name) TraceSpan const TRACE_CONCAT(traceSpan, __LINE__){name}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include "InputDevice.hpp"
+
+/**
+ * A controller whose state is set by the program through
+ * GetBackend().Set(), such as for tests or simulation.
+ */
+using VirtualController = InputDevice<VirtualBackend>;
@@ -1,31 +1,142 @@
 #include "ctre/phoenix6/TalonFX.hpp"
+#include "ctre/phoenix6/Utils.hpp"
+#include "DeviceRegistry.hpp"
+#include "TalonFXTable.hpp"
+#include "DrivetrainSim.hpp"
 #include "RobotBase.hpp"
-#include "Joystick.hpp"
+#include "InputDevice.hpp"
+#include "InputScript.hpp"
+#include "Odometry.hpp"
+#include <algorithm>
+#include <math.h>
+#include <optional>
+#include <stdlib.h>
+#include <string.h>
+#include <type_traits>
 
 using namespace ctre::phoenix6;
 
+/* the controller backend is selected by the INPUT_BACKEND CMake option */
+#ifndef ROBOT_INPUT_BACKEND
+#define ROBOT_INPUT_BACKEND JoystickBackend
+#endif
+using Controller = InputDevice<ROBOT_INPUT_BACKEND>;
+
 /**
  * This is the main robot. Put all actuators, sensors,
  * game controllers, etc. in this class.
  */
 class Robot : public RobotBase {
+public:
+    /**
+     * How the drivetrain is controlled.
+     */
+    enum class DriveMode {
+        /** Open-loop duty cycle computed on the host; speed varies with battery voltage */
+        DutyCycle,
+        /** Wheel velocity setpoints tracked by the closed loop on each TalonFX at 1 kHz */
+        Velocity,
+    };
+
 private:
     /* This can be a CANivore name, CANivore serial number,
-     * SocketCAN interface, or "*" to select any CANivore. */
+     * SocketCAN interface, or "*" to select any CANivore.
+     * Devices may be spread over several buses. */
     static constexpr char const *CANBUS_NAME = "*";
 
-    /* devices */
-    hardware::TalonFX leftLeader{0, CANBUS_NAME};
-    hardware::TalonFX leftFollower{1, CANBUS_NAME};
-    hardware::TalonFX rightLeader{2, CANBUS_NAME};
-    hardware::TalonFX rightFollower{3, CANBUS_NAME};
+    /* devices, with the I/O of each bus on its own worker thread;
+     * control requests only put frames on the bus when they change */
+    DeviceRegistry devices;
+
+    /* drivetrain CAN IDs */
+    static constexpr int kLeftLeader = 0;
+    static constexpr int kLeftFollower = 1;
+    static constexpr int kRightLeader = 2;
+    static constexpr int kRightFollower = 3;
+
+    /* the leaders are driven together, and the followers only ever follow them */
+    TalonFXTable<kLeftLeader, kRightLeader> leaders{devices, CANBUS_NAME};
+    TalonFXTable<kLeftFollower, kRightFollower> followers{devices, CANBUS_NAME};
+
+    hardware::TalonFX &leftLeader = leaders.Get<kLeftLeader>();
+    hardware::TalonFX &leftFollower = followers.Get<kLeftFollower>();
+    hardware::TalonFX &rightLeader = leaders.Get<kRightLeader>();
+    hardware::TalonFX &rightFollower = followers.Get<kRightFollower>();
 
     /* control requests */
     controls::DutyCycleOut leftOut{0};
     controls::DutyCycleOut rightOut{0};
+    controls::VelocityVoltage leftVelocityOut{0_tps};
+    controls::VelocityVoltage rightVelocityOut{0_tps};
+
+    /* the rotor velocity commanded at full stick, a little under the free speed */
+    static constexpr units::turns_per_second_t kMaxVelocity{90};
+
+    DriveMode driveMode = DriveMode::Velocity;
+
+    /* drivetrain geometry */
+    static constexpr double kGearRatio = 10.71;
+    static constexpr double kWheelRadiusMeters = 0.0762;
+    static constexpr double kTrackWidthMeters = 0.6;
+
+    /* pose estimation at 250 Hz, independent of the loop period */
+    Odometry odometry{leftLeader, rightLeader, {kGearRatio, kWheelRadiusMeters, kTrackWidthMeters}};
+
+    /* measured velocities of the leaders, for the tracking error, refreshed by the registry */
+    StatusSignal<units::turns_per_second_t> &leftVelocity = leftLeader.GetVelocity();
+    StatusSignal<units::turns_per_second_t> &rightVelocity = rightLeader.GetVelocity();
 
     /* joystick */
-    Joystick joy{0};
+    Controller joy{0};
+
+    /* telemetry of the motor outputs */
+    Telemetry::Channel leftOutputLog = Telemetry::kInvalidChannel;
+    Telemetry::Channel rightOutputLog = Telemetry::kInvalidChannel;
+    Telemetry::Channel leftErrorLog = Telemetry::kInvalidChannel;
+    Telemetry::Channel rightErrorLog = Telemetry::kInvalidChannel;
+    Telemetry::Channel poseXLog = Telemetry::kInvalidChannel;
+    Telemetry::Channel poseYLog = Telemetry::kInvalidChannel;
+    Telemetry::Channel poseHeadingLog = Telemetry::kInvalidChannel;
+
+    /* state published to local tools such as StateReader */
+    SharedStatePublisher::Entry leftOutputState = SharedStatePublisher::kInvalidEntry;
+    SharedStatePublisher::Entry rightOutputState = SharedStatePublisher::kInvalidEntry;
+    SharedStatePublisher::Entry leftVelocityState = SharedStatePublisher::kInvalidEntry;
+    SharedStatePublisher::Entry rightVelocityState = SharedStatePublisher::kInvalidEntry;
+    SharedStatePublisher::Entry connectedState = SharedStatePublisher::kInvalidEntry;
+    SharedStatePublisher::Entry enableButtonState = SharedStatePublisher::kInvalidEntry;
+    SharedStatePublisher::Entry speedAxisState = SharedStatePublisher::kInvalidEntry;
+    SharedStatePublisher::Entry turnAxisState = SharedStatePublisher::kInvalidEntry;
+    SharedStatePublisher::Entry poseXState = SharedStatePublisher::kInvalidEntry;
+    SharedStatePublisher::Entry poseYState = SharedStatePublisher::kInvalidEntry;
+    SharedStatePublisher::Entry poseHeadingState = SharedStatePublisher::kInvalidEntry;
+
+    /* tracking error over the current enable, for comparing the drive modes */
+    double leftSquaredError = 0;
+    double rightSquaredError = 0;
+    uint64_t trackedCycles = 0;
+
+    /* simulation of the drivetrain and the driver */
+    std::optional<DrivetrainSim> drivetrainSim;
+    InputScript driverScript;
+    units::second_t lastSimTime = 0_s;
+
+    /* controller mappings, resolved at compile time */
+    static constexpr int kEnableButton = Controller::MapButton(InputButton::RightShoulder);
+    static constexpr int kSpeedAxis = Controller::MapAxis(InputAxis::LeftY);
+    static constexpr int kTurnAxis = Controller::MapAxis(InputAxis::RightX);
+    static constexpr int kDriveModeButton = Controller::MapButton(InputButton::Start);
+
+#if ROBOT_COMMANDS
+    /* the drivetrain follows the arcade drive unless a command requires it */
+    Subsystem drivetrain;
+    double commandSpeed = 0;
+    double commandTurn = 0;
+    static constexpr int kRoutineButton = Controller::MapButton(InputButton::X);
+
+    Command DriveFor(double speed, double turn, units::second_t duration);
+    Command DriveAndTurn();
+#endif
 
 public:
     /* main robot interface */
@@ -38,6 +149,22 @@ public:
 
     void DisabledInit() override;
     void DisabledPeriodic() override;
+
+    void SimulationInit() override;
+    void SimulationPeriodic() override;
+
+    /**
+     * Sets how the drivetrain is controlled. The Start button
+     * also toggles between the modes.
+     */
+    void SetDriveMode(DriveMode mode) { driveMode = mode; }
+
+private:
+    static char const *GetDriveModeName(DriveMode mode);
+    static configs::Slot0Configs GetVelocityGains();
+    void PrintTrackingError();
+    template <typename Backend>
+    void AddNetworkStats(InputDevice<Backend> &device);
 };
 
 /**
@@ -47,17 +174,71 @@ void Robot::RobotInit()
 {
     configs::TalonFXConfiguration fx_cfg{};
 
-    /* the left motor is CCW+ */
-    fx_cfg.MotorOutput.Inverted = signals::InvertedValue::CounterClockwise_Positive;
-    leftLeader.GetConfigurator().Apply(fx_cfg);
+    /* the velocity closed loop on the device */
+    fx_cfg.Slot0 = GetVelocityGains();
 
-    /* the right motor is CW+ */
-    fx_cfg.MotorOutput.Inverted = signals::InvertedValue::Clockwise_Positive;
-    rightLeader.GetConfigurator().Apply(fx_cfg);
+    /* the left motor is CCW+, and the right motor is CW+ */
+    configs::TalonFXConfiguration left_cfg = fx_cfg;
+    configs::TalonFXConfiguration right_cfg = fx_cfg;
+    left_cfg.MotorOutput.Inverted = signals::InvertedValue::CounterClockwise_Positive;
+    right_cfg.MotorOutput.Inverted = signals::InvertedValue::Clockwise_Positive;
+    leaders.SetConfigs(left_cfg, right_cfg);
+
+    /* configure all devices at once, only applying what changed since the last run */
+    if (!devices.ApplyConfigs()) {
+        fprintf(stderr, "Warning: Not every device could be configured\n");
+    }
+    devices.PrintConfigReports();
 
     /* set follower motors to follow leaders; do NOT oppose the leaders' inverts */
-    leftFollower.SetControl(controls::Follower{leftLeader.GetDeviceID(), false});
-    rightFollower.SetControl(controls::Follower{rightLeader.GetDeviceID(), false});
+    leftFollower.SetControl(controls::Follower{kLeftLeader, false});
+    rightFollower.SetControl(controls::Follower{kRightLeader, false});
+
+    /* ignore small stick movements around center, so a released stick reads exactly 0 */
+    joy.SetAxisShaping(kSpeedAxis, 0.05);
+    joy.SetAxisShaping(kTurnAxis, 0.05);
+
+    /* log the joystick for --record and --replay */
+    AddLoggedInput(joy);
+
+    /* log the requested outputs every cycle */
+    leftOutputLog = GetTelemetry().AddChannel("leftOutput");
+    rightOutputLog = GetTelemetry().AddChannel("rightOutput");
+    leftErrorLog = GetTelemetry().AddChannel("leftTrackingError");
+    rightErrorLog = GetTelemetry().AddChannel("rightTrackingError");
+    poseXLog = GetTelemetry().AddChannel("poseX");
+    poseYLog = GetTelemetry().AddChannel("poseY");
+    poseHeadingLog = GetTelemetry().AddChannel("poseHeading");
+
+    /* publish the outputs, sensors and driver inputs every cycle */
+    leftOutputState = GetSharedState().AddEntry("drive.leftOutput", SharedState::Type::Double);
+    rightOutputState = GetSharedState().AddEntry("drive.rightOutput", SharedState::Type::Double);
+    leftVelocityState = GetSharedState().AddEntry("drive.leftVelocity", SharedState::Type::Double);
+    rightVelocityState = GetSharedState().AddEntry("drive.rightVelocity", SharedState::Type::Double);
+    connectedState = GetSharedState().AddEntry("input.connected", SharedState::Type::Bool);
+    enableButtonState = GetSharedState().AddEntry("input.enableButton", SharedState::Type::Bool);
+    speedAxisState = GetSharedState().AddEntry("input.speedAxis", SharedState::Type::Double);
+    turnAxisState = GetSharedState().AddEntry("input.turnAxis", SharedState::Type::Double);
+    poseXState = GetSharedState().AddEntry("pose.x", SharedState::Type::Double);
+    poseYState = GetSharedState().AddEntry("pose.y", SharedState::Type::Double);
+    poseHeadingState = GetSharedState().AddEntry("pose.heading", SharedState::Type::Double);
+
+    AddNetworkStats(joy);
+
+    /* refresh the leader velocities with the rest of their bus each cycle */
+    leaders.AddSignals([](hardware::TalonFX &leader) {
+        return std::vector<BaseStatusSignal *>{&leader.GetVelocity()};
+    });
+    devices.SetControlPeriod(GetLoopTime());
+    devices.Start();
+
+    /* a simulation or replay runs faster than real time, so the odometry thread could not keep up */
+    if (!IsSimulation() && !IsReplaying()) {
+        odometry.Start();
+    }
+
+    /* optionally run the robot loop as soon as fresh velocity data arrives from both leaders */
+    // SetSynchronousSignals({&leftLeader.GetVelocity(), &rightLeader.GetVelocity()});
 }
 
 /**
@@ -65,8 +246,40 @@ void Robot::RobotInit()
  */
 void Robot::RobotPeriodic()
 {
+    /* refresh every bus in parallel, which also waits for the previous cycle's controls */
+    {
+        TRACE_SPAN("DeviceRefresh");
+        /* waiting on the bus workers is the one place the cycle blocks on purpose */
+        HOT_PATH_PERMIT();
+        devices.Refresh();
+    }
+
     /* periodically check that the joystick is still good */
     joy.Periodic();
+
+    auto const &input = joy.Snapshot();
+    GetSharedState().Publish(connectedState, input.connected);
+    GetSharedState().Publish(enableButtonState, input.connected && input.GetButton(kEnableButton));
+    GetSharedState().Publish(speedAxisState, input.axes[kSpeedAxis]);
+    GetSharedState().Publish(turnAxisState, input.axes[kTurnAxis]);
+    GetSharedState().Publish(leftVelocityState, leftVelocity.GetValue().value());
+    GetSharedState().Publish(rightVelocityState, rightVelocity.GetValue().value());
+
+    /* log the pose as of the start of this cycle */
+    if (auto const pose = odometry.GetPoseAt(utils::GetCurrentTimeSeconds())) {
+        GetTelemetry().Record(poseXLog, pose->xMeters);
+        GetTelemetry().Record(poseYLog, pose->yMeters);
+        GetTelemetry().Record(poseHeadingLog, pose->headingRadians);
+        GetSharedState().Publish(poseXState, pose->xMeters);
+        GetSharedState().Publish(poseYState, pose->yMeters);
+        GetSharedState().Publish(poseHeadingState, pose->headingRadians);
+    }
+
+    if (joy.GetButtonPressed(kDriveModeButton)) {
+        PrintTrackingError();
+        driveMode = driveMode == DriveMode::Velocity ? DriveMode::DutyCycle : DriveMode::Velocity;
+        GetTelemetry().Print(stdout, "Drive mode: %s\n", GetDriveModeName(driveMode));
+    }
 }
 
 /**
@@ -74,53 +287,278 @@ void Robot::RobotPeriodic()
  */
 bool Robot::IsEnabled()
 {
+    auto const &input = joy.Snapshot();
+
     /* enable while joystick is an Xbox controller (6 axes),
      * and we are holding the right bumper */
-    if (joy.GetNumAxes() < 6) return false;
-    return joy.GetButton(5); // SDL_CONTROLLER_BUTTON_RIGHTSHOULDER
+    if (!input.connected || input.numAxes < 6) return false;
+    return input.GetButton(kEnableButton);
 }
 
 /**
  * Runs when transitioning from disabled to enabled.
  */
-void Robot::EnabledInit() {}
+void Robot::EnabledInit()
+{
+    GetTelemetry().Print(stdout, "Drive mode: %s\n", GetDriveModeName(driveMode));
+}
 
 /**
  * Runs periodically while enabled.
  */
 void Robot::EnabledPeriodic()
 {
+    auto const &input = joy.Snapshot();
+
     /* arcade drive */
-    double speed = -joy.GetAxis(1); // SDL_CONTROLLER_AXIS_LEFTY
-    double turn = joy.GetAxis(4); // SDL_CONTROLLER_AXIS_RIGHTX
+    double speed = -input.axes[kSpeedAxis];
+    double turn = input.axes[kTurnAxis];
+
+#if ROBOT_COMMANDS
+    if (joy.GetButtonPressed(kRoutineButton)) {
+        GetCommandScheduler().Schedule(DriveAndTurn().Requires(drivetrain));
+    }
+    if (GetCommandScheduler().IsRequired(drivetrain)) {
+        speed = commandSpeed;
+        turn = commandTurn;
+    }
+#endif
+
+    /* scale both sides down together when either is past full output, keeping the ratio between them,
+     * so the velocity targets (and the tracking error against them) stay within kMaxVelocity */
+    double left = speed + turn;
+    double right = speed - turn;
+    double const scale = std::max({1.0, fabs(left), fabs(right)});
+    left /= scale;
+    right /= scale;
 
-    leftOut.Output = speed + turn;
-    rightOut.Output = speed - turn;
+    if (driveMode == DriveMode::Velocity) {
+        /* the devices close the loop on their own, independent of our timing */
+        leftVelocityOut.Velocity = left * kMaxVelocity;
+        rightVelocityOut.Velocity = right * kMaxVelocity;
+        leaders.SetControls(leftVelocityOut, rightVelocityOut);
+    } else {
+        leftOut.Output = left;
+        rightOut.Output = right;
+        leaders.SetControls(leftOut, rightOut);
+    }
 
-    leftLeader.SetControl(leftOut);
-    rightLeader.SetControl(rightOut);
+    /* track both modes against the same velocity target */
+    double const leftError = (left * kMaxVelocity - leftVelocity.GetValue()).value();
+    double const rightError = (right * kMaxVelocity - rightVelocity.GetValue()).value();
+    leftSquaredError += leftError * leftError;
+    rightSquaredError += rightError * rightError;
+    ++trackedCycles;
+
+    GetTelemetry().Record(leftOutputLog, left);
+    GetTelemetry().Record(rightOutputLog, right);
+    GetTelemetry().Record(leftErrorLog, leftError);
+    GetTelemetry().Record(rightErrorLog, rightError);
+    GetSharedState().Publish(leftOutputState, left);
+    GetSharedState().Publish(rightOutputState, right);
+
+    devices.SendControls();
 }
 
 /**
  * Runs when transitioning from enabled to disabled,
  * including after robot startup.
  */
-void Robot::DisabledInit() {}
+void Robot::DisabledInit()
+{
+    PrintTrackingError();
+}
 
 /**
  * Runs periodically while disabled.
  */
 void Robot::DisabledPeriodic()
 {
-    leftLeader.SetControl(controls::NeutralOut{});
-    rightLeader.SetControl(controls::NeutralOut{});
+    leaders.SetControl(controls::NeutralOut{});
+
+    GetTelemetry().Record(leftOutputLog, 0);
+    GetTelemetry().Record(rightOutputLog, 0);
+    GetSharedState().Publish(leftOutputState, 0);
+    GetSharedState().Publish(rightOutputState, 0);
+
+    devices.SendControls();
+}
+
+#if ROBOT_COMMANDS
+/**
+ * Drives with the given arcade outputs for a while.
+ */
+Command Robot::DriveFor(double speed, double turn, units::second_t duration)
+{
+    commandSpeed = speed;
+    commandTurn = turn;
+    co_await WaitFor(duration);
+    commandSpeed = 0;
+    commandTurn = 0;
+}
+
+/**
+ * Drives forward 2 m, waits until the left side has stopped, then turns in place.
+ */
+Command Robot::DriveAndTurn()
+{
+    auto const start = odometry.GetLatest();
+    auto const traveled = [this, start] {
+        auto const pose = odometry.GetLatest();
+        return start && pose ? hypot(pose->xMeters - start->xMeters, pose->yMeters - start->yMeters) : 0.0;
+    };
+
+    /* without odometry (such as in simulation), give up on the distance after a while */
+    commandSpeed = 0.3;
+    commandTurn = 0;
+    co_await WaitUntil([&] { return traveled() >= 2.0; }, 3_s);
+    commandSpeed = 0;
+
+    /* every check acts on fresh velocity data */
+    while (fabs(leftVelocity.GetValue().value()) > 1) {
+        if (!co_await WaitForUpdate(leftVelocity, 0.5_s)) break;
+    }
+
+    co_await DriveFor(0, 0.3, 1_s);
+}
+#endif
+
+/**
+ * Publishes the latency and loss of the given controller once
+ * a second, if it is received over the network.
+ */
+template <typename Backend>
+void Robot::AddNetworkStats(InputDevice<Backend> &device)
+{
+    if constexpr (std::is_same_v<Backend, NetworkBackend>) {
+        auto const latencyState = GetSharedState().AddEntry("input.latencyP99Us", SharedState::Type::Double);
+        auto const lostState = GetSharedState().AddEntry("input.lostPackets", SharedState::Type::Int64);
+        auto const reorderedState = GetSharedState().AddEntry("input.reorderedPackets", SharedState::Type::Int64);
+        AddPeriodic([this, &device, latencyState, lostState, reorderedState] {
+            auto const stats = device.GetBackend().GetStats();
+            GetSharedState().Publish(latencyState, stats.latency.p99.value());
+            GetSharedState().Publish(lostState, stats.lost);
+            GetSharedState().Publish(reorderedState, stats.reordered);
+        }, 1000_ms, 5_ms);
+    }
+}
+
+/**
+ * Returns the name of the given drive mode.
+ */
+/*static*/ char const *Robot::GetDriveModeName(DriveMode mode)
+{
+    switch (mode) {
+        case DriveMode::DutyCycle: return "DutyCycle";
+        case DriveMode::Velocity: return "Velocity";
+    }
+    return "Unknown";
+}
+
+/**
+ * Returns the gains of the velocity closed loop on the devices, in volts
+ * per rotor rps: kV is 12 V over the free speed, kS overcomes friction,
+ * and kP corrects the rest.
+ */
+/*static*/ configs::Slot0Configs Robot::GetVelocityGains()
+{
+    configs::Slot0Configs gains{};
+    gains.kS = 0.1;
+    gains.kV = 0.12;
+    gains.kP = 0.11;
+    return gains;
+}
+
+/**
+ * Prints the RMS tracking error since it was last printed.
+ */
+void Robot::PrintTrackingError()
+{
+    if (trackedCycles == 0) return;
+
+    GetTelemetry().Print(stdout, "%s tracking error over %llu cycles: left %.2f rps RMS, right %.2f rps RMS\n",
+            GetDriveModeName(driveMode), (unsigned long long)trackedCycles,
+            sqrt(leftSquaredError / trackedCycles), sqrt(rightSquaredError / trackedCycles));
+
+    leftSquaredError = 0;
+    rightSquaredError = 0;
+    trackedCycles = 0;
+}
+
+/**
+ * Runs once in simulation, after RobotInit.
+ */
+void Robot::SimulationInit()
+{
+    DrivetrainSim::Constants constants{};
+    constants.gearRatio = kGearRatio;
+    constants.wheelRadiusMeters = kWheelRadiusMeters;
+    constants.trackWidthMeters = kTrackWidthMeters;
+    constants.velocityGains = GetVelocityGains();
+    drivetrainSim.emplace(leftLeader, leftFollower, rightLeader, rightFollower, constants);
+
+    /* drive forward, arc to the right, let go of the enable, then unplug */
+    driverScript
+        .At(0_s, InputScript::Gamepad({}, {}))
+        .At(1_s, InputScript::Gamepad({kEnableButton}, {{kSpeedAxis, -0.5}}))
+        .At(4_s, InputScript::Gamepad({kEnableButton}, {{kSpeedAxis, -0.5}, {kTurnAxis, 0.1}}))
+        .At(6_s, InputScript::Gamepad({}, {{kSpeedAxis, -0.5}}))
+        .At(8_s, InputState{});
+}
+
+/**
+ * Runs in simulation at the start of every cycle.
+ */
+void Robot::SimulationPeriodic()
+{
+    auto const now = GetCycleTime();
+    /* the motors apply the last cycle's requests, like on the real robot */
+    drivetrainSim->SetControls(devices.GetControl(leaders.GetHandle<kLeftLeader>()),
+                               devices.GetControl(leaders.GetHandle<kRightLeader>()));
+    drivetrainSim->Update(now - lastSimTime);
+
+    /* report the pose once per simulated second of driving */
+    if (fabs(drivetrainSim->GetLeftSpeed()) > 0.01 && (int)now.value() != (int)lastSimTime.value()) {
+        auto const pose = drivetrainSim->GetPose();
+        GetTelemetry().Print(stdout, "t=%.0fs x=%.2fm y=%.2fm heading=%.1fdeg\n",
+                now.value(), pose.xMeters, pose.yMeters, pose.headingRadians * 180 / M_PI);
+    }
+    lastSimTime = now;
+
+    driverScript.Apply(now, GetSimulatedInput(0));
 }
 
 /* ------ main function ------ */
-int main()
+int main(int argc, char **argv)
 {
     /* create and run robot */
     Robot robot{};
+
+    /* publish the loop state for StateReader and other local tools, including in simulation */
+    robot.SetSharedStateName(SharedState::kDefaultName);
+
+#if ROBOT_HOT_PATH_GUARD
+    /* a guard build checks that the periodic functions never allocate or block, so --sim and --replay prove it */
+    robot.SetHotPathGuard(HotPathGuard::Mode::Report, true);
+#endif
+
+    /* --record <file> records every cycle, --replay <file> runs a recording offline,
+     * and --sim <seconds> runs a scripted simulation faster than real time */
+    if (argc == 3 && strcmp(argv[1], "--replay") == 0) {
+        return robot.Replay(argv[2]);
+    }
+    if (argc == 3 && strcmp(argv[1], "--sim") == 0) {
+        return robot.RunSimulation(units::second_t{atof(argv[2])});
+    }
+    if (argc == 3 && strcmp(argv[1], "--record") == 0) {
+        robot.SetRecordingFile(argv[2]);
+    }
+
     // robot.SetLoopTime(20_ms); // optionally change loop time for periodic calls
+    // robot.SetSpinTime(50_us); // optionally busy-wait before each deadline to reduce wake-up jitter
+    // robot.SetRealtimeProfile(RealtimeProfile::Recommended()); // optionally run the loop as a real-time thread
+    // robot.SetTelemetryFile("telemetry.bin"); // optionally log the telemetry samples to a file
+    // robot.SetTraceFile("trace"); // optionally dump the last cycles to trace-<n>.json after each loop overrun
+    // robot.SetDriveMode(Robot::DriveMode::DutyCycle); // optionally start in the open-loop drive mode
     return robot.Run();
 }